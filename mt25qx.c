@@ -2,6 +2,10 @@
 #include <assert.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#ifdef __EBI_MT25Qx_METRICS
+#include <stdarg.h>
+#endif
 
 struct mt25qx_s {
     mt25qxSpiMode_e eSpiMode;
@@ -10,8 +14,293 @@ struct mt25qx_s {
     mt25qxTxData_f fTxData;
     mt25qxSleepMs_f fSleep;
     bool bIs4BytesAddrMode;
+#if defined(__EBI_MT25Qx_METRICS) || defined(__EBI_MT25Qx_TRACE)
+    mt25qxTickUs_f fTickUs;
+#endif
+#ifdef __EBI_MT25Qx_TRACE
+    mt25qxTrace_s * psTrace;
+#endif
+#ifdef __EBI_MT25Qx_METRICS
+    mt25qxMetricsOp_e eCurOp; // ? outermost operation being measured, MMOAmount if none
+    mt25qxWireAmount_e eDataWires; // ? data phase wires of the last command, for rx/tx cycles
+    mt25qxMetrics_s sMetrics;
+#endif
 };
 
+#ifdef __EBI_MT25Qx_METRICS
+
+typedef struct {
+    bool bOuter;
+    unsigned long long nStartUs;
+} _opScope_s;
+
+#define _OP_BEGIN(cpsThis, ceOp) const _opScope_s csOpScope = _opBegin(cpsThis, ceOp)
+#define _OP_END(cpsThis) _opEnd(cpsThis, &csOpScope)
+
+#else
+
+#define _OP_BEGIN(cpsThis, ceOp)
+#define _OP_END(cpsThis)
+
+#endif /* __EBI_MT25Qx_METRICS */
+
+#ifdef __EBI_MT25Qx_TRACE
+#define _TRACE(cpsThis, ceKind, cpcsCfgCmd, czLen) _trace(cpsThis, ceKind, cpcsCfgCmd, czLen)
+#else
+#define _TRACE(cpsThis, ceKind, cpcsCfgCmd, czLen)
+#endif /* __EBI_MT25Qx_TRACE */
+
+static
+unsigned long long
+_phaseClkCycles(
+    const size_t czBytes,
+    const mt25qxWireAmount_e ceWireAmount
+) {
+    switch ( ceWireAmount )
+    {
+    case MWA1Wire:
+        return 8ULL * czBytes;
+
+    case MWA2Wire:
+        return 4ULL * czBytes;
+
+    case MWA4Wire:
+        return 2ULL * czBytes;
+
+    default: /* MWA0Wire */
+        return 0;
+    }
+}
+
+#if defined(__EBI_MT25Qx_METRICS) || defined(__EBI_MT25Qx_TRACE)
+
+static
+unsigned long long
+_tickUs(
+    const mt25qx_s * const cpcsThis
+) {
+    return ( NULL == cpcsThis->fTickUs ) ? ( 0 ) : ( cpcsThis->fTickUs() ) ;
+}
+
+#endif
+
+#ifdef __EBI_MT25Qx_TRACE
+
+static
+void
+_trace(
+    mt25qx_s * const cpsThis,
+    const mt25qxTraceKind_e ceKind,
+    const mt25qxCfgCmd_s * const cpcsCfgCmd,
+    const size_t czLen
+) {
+    mt25qxTrace_s * const cpsTrace = cpsThis->psTrace;
+    mt25qxTraceRec_s * psRec = NULL;
+
+    if ( NULL == cpsTrace )
+    {
+        return;
+    }
+
+    psRec = &cpsTrace->psRecs[cpsTrace->nHead];
+    cpsTrace->nHead = ( cpsTrace->nHead + 1 == cpsTrace->nCapacity ) ? ( 0 ) : ( cpsTrace->nHead + 1 ) ;
+    ++cpsTrace->nTotal;
+
+    psRec->nTimeUs = (unsigned int)_tickUs(cpsThis);
+    psRec->nLen = (unsigned int)czLen;
+    psRec->nKind = (unsigned char)ceKind;
+
+    if ( NULL == cpcsCfgCmd )
+    {
+        psRec->nAddr = 0;
+        psRec->nCode = 0;
+        psRec->nWires = 0;
+        psRec->nDummyClkCycles = 0;
+        return;
+    }
+
+    psRec->nAddr = cpcsCfgCmd->sAddr.nVal;
+    psRec->nCode = cpcsCfgCmd->sCode.nVal;
+    psRec->nDummyClkCycles = cpcsCfgCmd->nDummyClkCycles;
+    psRec->nWires = (unsigned char)(
+        ( ( cpcsCfgCmd->sCode.eWireAmount & 0x3 ) << 0 ) |
+        ( ( cpcsCfgCmd->sAddr.eWireAmount & 0x3 ) << 2 ) |
+        ( ( cpcsCfgCmd->sData.eWireAmount & 0x3 ) << 4 ) |
+        ( ( true == cpcsCfgCmd->bIs4BytesAddrMode ) ? ( 1 << 6 ) : ( 0 ) )
+    );
+}
+
+#endif /* __EBI_MT25Qx_TRACE */
+
+#ifdef __EBI_MT25Qx_METRICS
+
+static
+_opScope_s
+_opBegin(
+    mt25qx_s * const cpsThis,
+    const mt25qxMetricsOp_e ceOp
+) {
+    _opScope_s sScope = { false, 0 };
+
+    /* nested calls (e.g. mt25qxErase -> mt25qxEraseStart) belong to the outermost one */
+    if ( NULL != cpsThis && MMOAmount == cpsThis->eCurOp )
+    {
+        cpsThis->eCurOp = ceOp;
+        sScope.bOuter = true;
+        sScope.nStartUs = _tickUs(cpsThis);
+    }
+
+    return sScope;
+}
+
+static
+void
+_opEnd(
+    mt25qx_s * const cpsThis,
+    const _opScope_s * const cpcsScope
+) {
+    mt25qxMetricsOp_s * psOp = NULL;
+    unsigned long long nUs = 0;
+    unsigned int nBucket = 0;
+
+    if ( false == cpcsScope->bOuter )
+    {
+        return;
+    }
+
+    psOp = &cpsThis->sMetrics.asOp[cpsThis->eCurOp];
+    nUs = _tickUs(cpsThis) - cpcsScope->nStartUs;
+    cpsThis->eCurOp = MMOAmount;
+
+    for ( nBucket = 0; ( nUs >> nBucket ) > 1 && __EBI_MT25Qx_METRICS_BUCKETS - 1 > nBucket; ++nBucket ) {}
+
+    ++psOp->nCount;
+    ++psOp->anHist[nBucket];
+    psOp->nTotalUs += nUs;
+    psOp->nMaxUs = ( nUs > psOp->nMaxUs ) ? ( nUs ) : ( psOp->nMaxUs ) ;
+}
+
+static
+void
+_addTime(
+    mt25qx_s * const cpsThis,
+    const unsigned long long cnStartUs,
+    const bool cbIsSleep
+) {
+    const unsigned long long cnUs = _tickUs(cpsThis) - cnStartUs;
+
+    if ( true == cbIsSleep )
+    {
+        cpsThis->sMetrics.nSleepUs += cnUs;
+    }
+    else
+    {
+        cpsThis->sMetrics.nXferUs += cnUs;
+    }
+
+    if ( MMOAmount == cpsThis->eCurOp )
+    {
+        return;
+    }
+
+    if ( true == cbIsSleep )
+    {
+        cpsThis->sMetrics.asOp[cpsThis->eCurOp].nSleepUs += cnUs;
+    }
+    else
+    {
+        cpsThis->sMetrics.asOp[cpsThis->eCurOp].nXferUs += cnUs;
+    }
+}
+
+#endif /* __EBI_MT25Qx_METRICS */
+
+/* every bus access and sleep goes through here */
+
+static
+mt25qxRet_e
+_cfgCmd(
+    mt25qx_s * const cpsThis,
+    const mt25qxCfgCmd_s * const cpcsCfgCmd
+) {
+    _TRACE(cpsThis, MTKCfgCmd, cpcsCfgCmd, cpcsCfgCmd->sData.zDataLen);
+
+#ifdef __EBI_MT25Qx_METRICS
+    const unsigned long long cnStartUs = _tickUs(cpsThis);
+    const mt25qxRet_e ceRet = cpsThis->fCfgCmd(cpcsCfgCmd);
+
+    _addTime(cpsThis, cnStartUs, false);
+    ++cpsThis->sMetrics.anCmdCount[cpcsCfgCmd->sCode.nVal];
+    cpsThis->eDataWires = cpcsCfgCmd->sData.eWireAmount;
+    cpsThis->sMetrics.nBusClkCycles += 
+        mt25qxCfgCmdClkCycles(cpcsCfgCmd) - 
+        _phaseClkCycles(cpcsCfgCmd->sData.zDataLen, cpcsCfgCmd->sData.eWireAmount);
+    return ceRet;
+#else
+    return cpsThis->fCfgCmd(cpcsCfgCmd);
+#endif
+}
+
+static
+mt25qxRet_e
+_rxData(
+    mt25qx_s * const cpsThis,
+    unsigned char * const cpnDataBuf, 
+    const size_t czDataLen
+) {
+    _TRACE(cpsThis, MTKRxData, NULL, czDataLen);
+
+#ifdef __EBI_MT25Qx_METRICS
+    const unsigned long long cnStartUs = _tickUs(cpsThis);
+    const mt25qxRet_e ceRet = cpsThis->fRxData(cpnDataBuf, czDataLen);
+
+    _addTime(cpsThis, cnStartUs, false);
+    cpsThis->sMetrics.nBusClkCycles += _phaseClkCycles(czDataLen, cpsThis->eDataWires);
+    return ceRet;
+#else
+    return cpsThis->fRxData(cpnDataBuf, czDataLen);
+#endif
+}
+
+static
+mt25qxRet_e
+_txData(
+    mt25qx_s * const cpsThis,
+    const unsigned char * const cpcnDataBuf, 
+    const size_t czDataLen
+) {
+    _TRACE(cpsThis, MTKTxData, NULL, czDataLen);
+
+#ifdef __EBI_MT25Qx_METRICS
+    const unsigned long long cnStartUs = _tickUs(cpsThis);
+    const mt25qxRet_e ceRet = cpsThis->fTxData(cpcnDataBuf, czDataLen);
+
+    _addTime(cpsThis, cnStartUs, false);
+    cpsThis->sMetrics.nBusClkCycles += _phaseClkCycles(czDataLen, cpsThis->eDataWires);
+    return ceRet;
+#else
+    return cpsThis->fTxData(cpcnDataBuf, czDataLen);
+#endif
+}
+
+static
+void
+_sleep(
+    mt25qx_s * const cpsThis,
+    unsigned int nMs
+) {
+    _TRACE(cpsThis, MTKSleep, NULL, nMs);
+
+#ifdef __EBI_MT25Qx_METRICS
+    const unsigned long long cnStartUs = _tickUs(cpsThis);
+
+    cpsThis->fSleep(nMs);
+    _addTime(cpsThis, cnStartUs, true);
+#else
+    cpsThis->fSleep(nMs);
+#endif
+}
+
 static
 mt25qxRet_e
 _txPureCfgCmd(
@@ -34,7 +323,7 @@ _txPureCfgCmd(
     sCfgCmd.nDummyClkCycles = 0;
     sCfgCmd.bIs4BytesAddrMode = cpsThis->bIs4BytesAddrMode;
 
-    return cpsThis->fCfgCmd(&sCfgCmd);
+    return _cfgCmd(cpsThis, &sCfgCmd);
 }
 
 mt25qx_s * 
@@ -64,6 +353,9 @@ assert( NULL != cfSleep );
         cpsThis->fRxData = cfRxData;
         cpsThis->fTxData = cfTxData;
         cpsThis->fSleep = cfSleep;
+#ifdef __EBI_MT25Qx_METRICS
+        cpsThis->eCurOp = MMOAmount;
+#endif
     }
 
     if ( 
@@ -111,36 +403,56 @@ mt25qxFree(
     free(pvThis);
 }
 
+static
 mt25qxRet_e
-mt25qxWaitIdle(
+_waitIdle(
     mt25qx_s * const cpsThis,
     const unsigned int nTimeoutMs
 ) {
     unsigned int nTryTimes = ( 0 == nTimeoutMs ) ? ( 1 ) : ( nTimeoutMs ) ;
+    mt25qxRet_e eRet = MRBusy;
 
-    if ( NULL == cpsThis )
+    do {
+        _sleep(cpsThis, 1);
+
+        eRet = mt25qxChkBusy(cpsThis);
+        --nTryTimes;
+    } while ( MRBusy == eRet && nTryTimes > 0 );
+
+#ifdef __EBI_MT25Qx_METRICS
     {
-        return MRFail;
+        const unsigned long long cnPolls = ( ( 0 == nTimeoutMs ) ? ( 1 ) : ( nTimeoutMs ) ) - nTryTimes;
+
+        cpsThis->sMetrics.nWaitIdlePolls += cnPolls;
+        if ( cnPolls > cpsThis->sMetrics.nWaitIdleMaxPolls )
+        {
+            cpsThis->sMetrics.nWaitIdleMaxPolls = cnPolls;
+        }
     }
+#endif
 
-    do {
-        cpsThis->fSleep(1);
+    return eRet;
+}
 
-        switch ( mt25qxChkBusy(cpsThis) )
-        {
-        case MRIdle:
-            return MRIdle;
+mt25qxRet_e
+mt25qxWaitIdle(
+    mt25qx_s * const cpsThis,
+    const unsigned int nTimeoutMs
+) {
+    mt25qxRet_e eRet = MRFail;
 
-        case MRFail:
-            return MRFail;
-        
-        default:
-            --nTryTimes;
-            break;
-        }
-    } while ( nTryTimes > 0 );
+    if ( NULL == cpsThis )
+    {
+        return MRFail;
+    }
+
+    {
+        _OP_BEGIN(cpsThis, MMOWaitIdle);
+        eRet = _waitIdle(cpsThis, nTimeoutMs);
+        _OP_END(cpsThis);
+    }
 
-    return MRBusy;
+    return eRet;
 }
 
 mt25qxRet_e 
@@ -164,13 +476,13 @@ mt25qxGetId(
     sCfgCmd.sData.zDataLen = sizeof(mt25qxId_s);
     sCfgCmd.nDummyClkCycles = 0;
 
-    eRet = cpsThis->fCfgCmd(&sCfgCmd);
+    eRet = _cfgCmd(cpsThis, &sCfgCmd);
     if ( MROkay != eRet )
     {
         return eRet;
     }
 
-    eRet = cpsThis->fRxData((unsigned char *)cpsId, sCfgCmd.sData.zDataLen);
+    eRet = _rxData(cpsThis, (unsigned char *)cpsId, sCfgCmd.sData.zDataLen);
     if ( MROkay != eRet )
     {
         return eRet;
@@ -214,13 +526,13 @@ mt25qxGetReg(
         return MRFail;
     }
 
-    eRet = cpsThis->fCfgCmd(&sCfgCmd);
+    eRet = _cfgCmd(cpsThis, &sCfgCmd);
     if ( MROkay != eRet )
     {
         return eRet;
     }
 
-    eRet = cpsThis->fRxData((unsigned char *)&cpsReg->uReg, sCfgCmd.sData.zDataLen);
+    eRet = _rxData(cpsThis, (unsigned char *)&cpsReg->uReg, sCfgCmd.sData.zDataLen);
     if ( MROkay != eRet )
     {
         return eRet;
@@ -266,13 +578,13 @@ mt25qxSetReg(
         return MRFail;
     }
 
-    eRet = cpsThis->fCfgCmd(&sCfgCmd);
+    eRet = _cfgCmd(cpsThis, &sCfgCmd);
     if ( MROkay != eRet )
     {
         return eRet;
     }
 
-    eRet = cpsThis->fTxData((unsigned char *)&cpcsReg->uReg, sCfgCmd.sData.zDataLen);
+    eRet = _txData(cpsThis, (unsigned char *)&cpcsReg->uReg, sCfgCmd.sData.zDataLen);
     if ( MROkay != eRet )
     {
         return eRet;
@@ -281,8 +593,9 @@ mt25qxSetReg(
     return MROkay;
 }
 
+static
 mt25qxRet_e 
-mt25qxFastRead(
+_fastRead(
     mt25qx_s * const cpsThis,
     const unsigned int cnAddr,
     unsigned char * const cpnDataBuf, 
@@ -331,13 +644,13 @@ mt25qxFastRead(
         break;
     }
 
-    eRet = cpsThis->fCfgCmd(&sCfgCmd);
+    eRet = _cfgCmd(cpsThis, &sCfgCmd);
     if ( MROkay != eRet )
     {
         return eRet;
     }
 
-    eRet = cpsThis->fRxData(cpnDataBuf, czDataLen);
+    eRet = _rxData(cpsThis, cpnDataBuf, czDataLen);
     if ( MROkay != eRet )
     {
         return eRet;
@@ -347,7 +660,22 @@ mt25qxFastRead(
 }
 
 mt25qxRet_e 
-mt25qxPageProgram(
+mt25qxFastRead(
+    mt25qx_s * const cpsThis,
+    const unsigned int cnAddr,
+    unsigned char * const cpnDataBuf, 
+    const size_t czDataLen
+) {
+    _OP_BEGIN(cpsThis, MMORead);
+    const mt25qxRet_e ceRet = _fastRead(cpsThis, cnAddr, cpnDataBuf, czDataLen);
+
+    _OP_END(cpsThis);
+    return ceRet;
+}
+
+static
+mt25qxRet_e 
+_pageProgramStart(
     mt25qx_s * const cpsThis,
     const unsigned int cnAddr,
     const unsigned char * const cpcnDataBuf, 
@@ -369,7 +697,7 @@ mt25qxPageProgram(
     sCfgCmd.sCode.eWireAmount = MWA1Wire;
     sCfgCmd.sAddr.eWireAmount = MWA1Wire;
     sCfgCmd.sAddr.nVal = cnAddr;
-    sCfgCmd.sData.zDataLen = ( czDataLen > 256 ) ? ( 256 ) : ( czDataLen );
+    sCfgCmd.sData.zDataLen = ( czDataLen > __EBI_MT25Qx_PAGE_SIZE ) ? ( __EBI_MT25Qx_PAGE_SIZE ) : ( czDataLen );
     sCfgCmd.nDummyClkCycles = 0;
     sCfgCmd.bIs4BytesAddrMode = cpsThis->bIs4BytesAddrMode;
 
@@ -392,32 +720,63 @@ mt25qxPageProgram(
         break;
     }
 
-    eRet = cpsThis->fCfgCmd(&sCfgCmd);
+    eRet = _cfgCmd(cpsThis, &sCfgCmd);
     if ( MROkay != eRet )
     {
         return eRet;
     }
 
-    eRet = cpsThis->fTxData(cpcnDataBuf, czDataLen);
+    eRet = _txData(cpsThis, cpcnDataBuf, sCfgCmd.sData.zDataLen);
     if ( MROkay != eRet )
     {
         return eRet;
     }
 
-    // ! needs to sleep for 1ms after page programming (to solve the timing problem)
-    cpsThis->fSleep(1); 
     return MROkay;
 }
 
 mt25qxRet_e 
-mt25qxErase(
+mt25qxPageProgramStart(
+    mt25qx_s * const cpsThis,
+    const unsigned int cnAddr,
+    const unsigned char * const cpcnDataBuf, 
+    const size_t czDataLen
+) {
+    _OP_BEGIN(cpsThis, MMOProgram);
+    const mt25qxRet_e ceRet = _pageProgramStart(cpsThis, cnAddr, cpcnDataBuf, czDataLen);
+
+    _OP_END(cpsThis);
+    return ceRet;
+}
+
+mt25qxRet_e 
+mt25qxPageProgram(
+    mt25qx_s * const cpsThis,
+    const unsigned int cnAddr,
+    const unsigned char * const cpcnDataBuf, 
+    const size_t czDataLen
+) {
+    _OP_BEGIN(cpsThis, MMOProgram);
+    const mt25qxRet_e ceRet = _pageProgramStart(cpsThis, cnAddr, cpcnDataBuf, czDataLen);
+
+    // ! needs to sleep for 1ms after page programming (to solve the timing problem)
+    if ( MROkay == ceRet && 0 != czDataLen )
+    {
+        _sleep(cpsThis, 1); 
+    }
+
+    _OP_END(cpsThis);
+    return ceRet;
+}
+
+static
+mt25qxRet_e 
+_eraseStart(
     mt25qx_s * const cpsThis,
     const unsigned int cnAddr,
     const mt25qxEraseSize_e ceSize
 ) {
-    mt25qxRet_e eRet = MROkay;
     mt25qxCfgCmd_s sCfgCmd = {0};
-    size_t zTypDelayMs = 0;
 
     if ( NULL == cpsThis )
     {
@@ -436,30 +795,68 @@ mt25qxErase(
     {
     case MES4KB:
         sCfgCmd.sCode.nVal = 0x20;
-        zTypDelayMs = 50;
         break;
 
     case MES32KB:
         sCfgCmd.sCode.nVal = 0x52;
-        zTypDelayMs = 100;
         break;
 
     default: /* MESBulk */
         sCfgCmd.sCode.nVal = 0x60;
         sCfgCmd.sAddr.eWireAmount = MWA0Wire;
         sCfgCmd.sAddr.nVal = 0;
-        zTypDelayMs = 153000;
         break;
     }
 
-    eRet = cpsThis->fCfgCmd(&sCfgCmd);
-    if ( MROkay != eRet )
+    return _cfgCmd(cpsThis, &sCfgCmd);
+}
+
+mt25qxRet_e 
+mt25qxEraseStart(
+    mt25qx_s * const cpsThis,
+    const unsigned int cnAddr,
+    const mt25qxEraseSize_e ceSize
+) {
+    _OP_BEGIN(cpsThis, MMOErase);
+    const mt25qxRet_e ceRet = _eraseStart(cpsThis, cnAddr, ceSize);
+
+    _OP_END(cpsThis);
+    return ceRet;
+}
+
+mt25qxRet_e 
+mt25qxErase(
+    mt25qx_s * const cpsThis,
+    const unsigned int cnAddr,
+    const mt25qxEraseSize_e ceSize
+) {
+    unsigned int nTypDelayMs = 0;
+
+    _OP_BEGIN(cpsThis, MMOErase);
+    const mt25qxRet_e ceRet = _eraseStart(cpsThis, cnAddr, ceSize);
+
+    switch ( ceSize )
     {
-        return eRet;
+    case MES4KB:
+        nTypDelayMs = 50;
+        break;
+
+    case MES32KB:
+        nTypDelayMs = 100;
+        break;
+
+    default: /* MESBulk */
+        nTypDelayMs = 153000;
+        break;
     }
 
-    cpsThis->fSleep(zTypDelayMs);
-    return MROkay;
+    if ( MROkay == ceRet )
+    {
+        _sleep(cpsThis, nTypDelayMs);
+    }
+
+    _OP_END(cpsThis);
+    return ceRet;
 }
 
 mt25qxRet_e
@@ -509,3 +906,248 @@ mt25qxTxPureCfgCmd(
 
     return _txPureCfgCmd(cpsThis, ceCode);
 }
+
+unsigned long long
+mt25qxCfgCmdClkCycles(
+    const mt25qxCfgCmd_s * const cpcsCfgCmd
+) {
+    if ( NULL == cpcsCfgCmd )
+    {
+        return 0;
+    }
+
+    return 
+        _phaseClkCycles(1, cpcsCfgCmd->sCode.eWireAmount) +
+        _phaseClkCycles(( true == cpcsCfgCmd->bIs4BytesAddrMode ) ? ( 4 ) : ( 3 ), cpcsCfgCmd->sAddr.eWireAmount) +
+        cpcsCfgCmd->nDummyClkCycles +
+        _phaseClkCycles(cpcsCfgCmd->sData.zDataLen, cpcsCfgCmd->sData.eWireAmount);
+}
+
+#if defined(__EBI_MT25Qx_METRICS) || defined(__EBI_MT25Qx_TRACE)
+
+void
+mt25qxSetClock(
+    mt25qx_s * const cpsThis,
+    const mt25qxTickUs_f cfTickUs
+) {
+    if ( NULL != cpsThis )
+    {
+        cpsThis->fTickUs = cfTickUs;
+    }
+}
+
+#endif
+
+#ifdef __EBI_MT25Qx_METRICS
+
+mt25qxRet_e
+mt25qxMetricsGet(
+    mt25qx_s * const cpsThis,
+    mt25qxMetrics_s * const cpsMetrics
+) {
+    if ( NULL == cpsThis || NULL == cpsMetrics )
+    {
+        return MRFail;
+    }
+
+    memcpy(cpsMetrics, &cpsThis->sMetrics, sizeof(mt25qxMetrics_s));
+    return MROkay;
+}
+
+mt25qxRet_e
+mt25qxMetricsReset(
+    mt25qx_s * const cpsThis
+) {
+    if ( NULL == cpsThis )
+    {
+        return MRFail;
+    }
+
+    memset(&cpsThis->sMetrics, 0, sizeof(mt25qxMetrics_s));
+    return MROkay;
+}
+
+static
+void
+_jsonAppend(
+    char * const cpcBuf,
+    const size_t czBufLen,
+    size_t * const cpzLen,
+    const char * const cpcFmt,
+    ...
+) {
+    va_list vArgs;
+    int nLen = 0;
+
+    va_start(vArgs, cpcFmt);
+    nLen = vsnprintf(
+        ( czBufLen > *cpzLen ) ? ( cpcBuf + *cpzLen ) : ( NULL ),
+        ( czBufLen > *cpzLen ) ? ( czBufLen - *cpzLen ) : ( 0 ),
+        cpcFmt, 
+        vArgs
+    );
+    va_end(vArgs);
+
+    *cpzLen += ( 0 < nLen ) ? ( (size_t)nLen ) : ( 0 );
+}
+
+size_t
+mt25qxMetricsDumpJson(
+    const mt25qxMetrics_s * const cpcsMetrics,
+    char * const cpcBuf,
+    const size_t czBufLen
+) {
+    static const char * const cpcOpName[MMOAmount] = { "read", "program", "erase", "wait_idle" };
+    const mt25qxMetricsOp_s * pcsOp = NULL;
+    const char * pcSep = "";
+    size_t zLen = 0;
+    unsigned int nIdx = 0;
+    unsigned int nOp = 0;
+
+    if ( NULL == cpcsMetrics )
+    {
+        return 0;
+    }
+
+    if ( NULL != cpcBuf && 0 < czBufLen )
+    {
+        cpcBuf[0] = '\0';
+    }
+
+    _jsonAppend(cpcBuf, czBufLen, &zLen, 
+        "{\"bus_clk_cycles\":%llu,\"sleep_us\":%llu,\"xfer_us\":%llu,\"wait_idle_polls\":%llu,\"wait_idle_max_polls\":%llu,\"cmd\":{",
+        cpcsMetrics->nBusClkCycles, cpcsMetrics->nSleepUs, cpcsMetrics->nXferUs,
+        cpcsMetrics->nWaitIdlePolls, cpcsMetrics->nWaitIdleMaxPolls
+    );
+
+    for ( nIdx = 0; 256 > nIdx; ++nIdx )
+    {
+        if ( 0 != cpcsMetrics->anCmdCount[nIdx] )
+        {
+            _jsonAppend(cpcBuf, czBufLen, &zLen, "%s\"0x%02X\":%llu", pcSep, nIdx, cpcsMetrics->anCmdCount[nIdx]);
+            pcSep = ",";
+        }
+    }
+
+    _jsonAppend(cpcBuf, czBufLen, &zLen, "},\"op\":{");
+
+    for ( nOp = 0; MMOAmount > nOp; ++nOp )
+    {
+        pcsOp = &cpcsMetrics->asOp[nOp];
+        _jsonAppend(cpcBuf, czBufLen, &zLen,
+            "%s\"%s\":{\"count\":%llu,\"total_us\":%llu,\"max_us\":%llu,\"sleep_us\":%llu,\"xfer_us\":%llu,\"hist_log2_us\":[",
+            ( 0 == nOp ) ? ( "" ) : ( "," ), cpcOpName[nOp],
+            pcsOp->nCount, pcsOp->nTotalUs, pcsOp->nMaxUs, pcsOp->nSleepUs, pcsOp->nXferUs
+        );
+
+        for ( nIdx = 0; __EBI_MT25Qx_METRICS_BUCKETS > nIdx; ++nIdx )
+        {
+            _jsonAppend(cpcBuf, czBufLen, &zLen, "%s%llu", ( 0 == nIdx ) ? ( "" ) : ( "," ), pcsOp->anHist[nIdx]);
+        }
+
+        _jsonAppend(cpcBuf, czBufLen, &zLen, "]}");
+    }
+
+    _jsonAppend(cpcBuf, czBufLen, &zLen, "}}");
+    return zLen;
+}
+
+#endif /* __EBI_MT25Qx_METRICS */
+
+#ifdef __EBI_MT25Qx_TRACE
+
+static
+void
+_putLe(
+    unsigned char * const cpnBuf,
+    const unsigned int cnVal,
+    const unsigned int cnBytes
+) {
+    unsigned int nIdx = 0;
+
+    for ( nIdx = 0; cnBytes > nIdx; ++nIdx )
+    {
+        cpnBuf[nIdx] = (unsigned char)( cnVal >> ( 8 * nIdx ) );
+    }
+}
+
+mt25qxRet_e
+mt25qxTraceInit(
+    mt25qxTrace_s * const cpsTrace,
+    mt25qxTraceRec_s * const cpsRecs,
+    const unsigned int cnCapacity
+) {
+    if ( NULL == cpsTrace || NULL == cpsRecs || 0 == cnCapacity )
+    {
+        return MRFail;
+    }
+
+    cpsTrace->psRecs = cpsRecs;
+    cpsTrace->nCapacity = cnCapacity;
+    cpsTrace->nHead = 0;
+    cpsTrace->nTotal = 0;
+    return MROkay;
+}
+
+void
+mt25qxTraceAttach(
+    mt25qx_s * const cpsThis,
+    mt25qxTrace_s * const cpsTrace
+) {
+    if ( NULL != cpsThis )
+    {
+        cpsThis->psTrace = cpsTrace;
+    }
+}
+
+mt25qxRet_e
+mt25qxTraceDump(
+    const mt25qxTrace_s * const cpcsTrace,
+    const mt25qxTraceWrite_f cfWrite
+) {
+    unsigned char anBuf[__EBI_MT25Qx_TRACE_RECORD_SIZE] = {0};
+    const mt25qxTraceRec_s * pcsRec = NULL;
+    unsigned int nCount = 0;
+    unsigned int nIdx = 0;
+    unsigned long long nLost = 0;
+
+    if ( NULL == cpcsTrace || NULL == cfWrite )
+    {
+        return MRFail;
+    }
+
+    nCount = ( cpcsTrace->nTotal > cpcsTrace->nCapacity ) ? ( cpcsTrace->nCapacity ) : ( (unsigned int)cpcsTrace->nTotal ) ;
+    nLost = cpcsTrace->nTotal - nCount;
+
+    memcpy(anBuf, __EBI_MT25Qx_TRACE_MAGIC, 4);
+    _putLe(&anBuf[4], __EBI_MT25Qx_TRACE_VERSION, 2);
+    _putLe(&anBuf[6], __EBI_MT25Qx_TRACE_RECORD_SIZE, 2);
+    _putLe(&anBuf[8], nCount, 4);
+    _putLe(&anBuf[12], ( 0xFFFFFFFFULL < nLost ) ? ( 0xFFFFFFFFU ) : ( (unsigned int)nLost ), 4);
+    if ( MROkay != cfWrite(anBuf, __EBI_MT25Qx_TRACE_HEADER_SIZE) )
+    {
+        return MRFail;
+    }
+
+    /* oldest first: right after the head once the ring has wrapped around */
+    for ( nIdx = 0; nCount > nIdx; ++nIdx )
+    {
+        pcsRec = &cpcsTrace->psRecs[( cpcsTrace->nHead + cpcsTrace->nCapacity - nCount + nIdx ) % cpcsTrace->nCapacity];
+
+        _putLe(&anBuf[0], pcsRec->nTimeUs, 4);
+        _putLe(&anBuf[4], pcsRec->nAddr, 4);
+        _putLe(&anBuf[8], pcsRec->nLen, 4);
+        anBuf[12] = pcsRec->nKind;
+        anBuf[13] = pcsRec->nCode;
+        anBuf[14] = pcsRec->nWires;
+        anBuf[15] = pcsRec->nDummyClkCycles;
+        if ( MROkay != cfWrite(anBuf, __EBI_MT25Qx_TRACE_RECORD_SIZE) )
+        {
+            return MRFail;
+        }
+    }
+
+    return MROkay;
+}
+
+#endif /* __EBI_MT25Qx_TRACE */
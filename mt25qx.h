@@ -9,6 +9,7 @@ extern "C" {
 #include <stdbool.h>
 
 #define __EBI_MT25Qx_PAGE_SIZE 256U
+#define __EBI_MT25Qx_SUBSECTOR_SIZE 4096U
 
 typedef enum { 
     MROkay, 
@@ -132,6 +133,96 @@ typedef mt25qxRet_e (*mt25qxTxData_f)(const unsigned char * const cpcnDataBuf, c
  */
 typedef void (*mt25qxSleepMs_f)(unsigned int nMs);
 
+/**
+ * @brief callback function: read the next N bytes of the source image
+ * @details
+ * - store how many bytes were read in cpzReadLen, less than czDataLen means end of image
+ */
+typedef mt25qxRet_e (*mt25qxSrcRead_f)(unsigned char * const cpnDataBuf, const size_t czDataLen, size_t * const cpzReadLen);
+
+#ifdef __EBI_MT25Qx_METRICS
+
+#define __EBI_MT25Qx_METRICS_BUCKETS 24U
+
+typedef enum {
+    MMORead,
+    MMOProgram,
+    MMOErase,
+    MMOWaitIdle,
+    MMOAmount
+} mt25qxMetricsOp_e;
+
+typedef struct {
+    unsigned long long nCount;
+    unsigned long long nTotalUs;
+    unsigned long long nMaxUs;
+    unsigned long long nSleepUs; // ? part of nTotalUs spent in fSleep
+    unsigned long long nXferUs; // ? part of nTotalUs spent in fCfgCmd, fRxData and fTxData
+    unsigned long long anHist[__EBI_MT25Qx_METRICS_BUCKETS]; // ? [0]: 0 to 1 us, [N >= 1]: 2^N to 2^(N+1) - 1 us, the last one also holds longer
+} mt25qxMetricsOp_s;
+
+typedef struct {
+    unsigned long long anCmdCount[256]; // ? indexed by opcode
+    unsigned long long nBusClkCycles; // ? opcode, address, dummy and data phases of every transfer
+    unsigned long long nSleepUs;
+    unsigned long long nXferUs;
+    unsigned long long nWaitIdlePolls; // ? mt25qxChkBusy calls made by mt25qxWaitIdle
+    unsigned long long nWaitIdleMaxPolls; // ? the most polls a single mt25qxWaitIdle call took
+    mt25qxMetricsOp_s asOp[MMOAmount];
+} mt25qxMetrics_s;
+
+#endif /* __EBI_MT25Qx_METRICS */
+
+#ifdef __EBI_MT25Qx_TRACE
+
+#define __EBI_MT25Qx_TRACE_MAGIC "M25T"
+#define __EBI_MT25Qx_TRACE_VERSION 1U
+#define __EBI_MT25Qx_TRACE_HEADER_SIZE 16U
+#define __EBI_MT25Qx_TRACE_RECORD_SIZE 16U
+
+typedef enum {
+    MTKCfgCmd,
+    MTKRxData,
+    MTKTxData,
+    MTKSleep
+} mt25qxTraceKind_e;
+
+typedef struct {
+    unsigned int nTimeUs; // ? low 32 bits of the clock when the call is made
+    unsigned int nAddr; // ? MTKCfgCmd: address
+    unsigned int nLen; // ? MTKCfgCmd: data length, MTKRxData/MTKTxData: payload length, MTKSleep: ms
+    unsigned char nKind; // ? mt25qxTraceKind_e
+    unsigned char nCode; // ? MTKCfgCmd: opcode
+    unsigned char nWires; // ? MTKCfgCmd: code[1:0], addr[3:2], data[5:4] as mt25qxWireAmount_e, bit 6: 4-byte address
+    unsigned char nDummyClkCycles; // ? MTKCfgCmd: dummy cycles
+} mt25qxTraceRec_s;
+
+/**
+ * @brief ring buffer of bus transactions, storage is provided by the caller
+ */
+typedef struct {
+    mt25qxTraceRec_s * psRecs;
+    unsigned int nCapacity;
+    unsigned int nHead; // ? next record to be written
+    unsigned long long nTotal; // ? records ever written, older ones are overwritten once it exceeds nCapacity
+} mt25qxTrace_s;
+
+/**
+ * @brief callback function: write N bytes of a trace dump, e.g. to a file
+ */
+typedef mt25qxRet_e (*mt25qxTraceWrite_f)(const unsigned char * const cpcnDataBuf, const size_t czDataLen);
+
+#endif /* __EBI_MT25Qx_TRACE */
+
+#if defined(__EBI_MT25Qx_METRICS) || defined(__EBI_MT25Qx_TRACE)
+
+/**
+ * @brief callback function: monotonic clock in microseconds
+ */
+typedef unsigned long long (*mt25qxTickUs_f)(void);
+
+#endif
+
 /**
  * @brief make a mt25qx_s instance via dynamic memory
  * @param ceSpiMode set this instance to run in what kind of spi mode
@@ -242,6 +333,8 @@ mt25qxFastRead(
  * - return MRFail if cnAddr is not end of 0x00
  * - return MROkay if "czDataLen" equals to 0
  * - auto cut off data more than __EBI_MT25Qx_PAGE_SIZE bytes
+ * - the cut off applies to the bytes given to fTxData() too, they always match the data length
+ *   announced to fCfgCmd() ( earlier versions passed the whole czDataLen to fTxData() )
  * @warning
  * - mt25qxTxPureCfgCmd(cpsThis, MPCCCWriteEnable) is required
  * - needs to be erased if the program location has been written
@@ -254,6 +347,27 @@ mt25qxPageProgram(
     const size_t czDataLen
 );
 
+/**
+ * @brief same as mt25qxPageProgram() but returns as soon as the data is sent
+ * @param cpsThis pointer to this instance
+ * @param cnAddr 0x00000000 + ( N * __EBI_MT25Qx_PAGE_SIZE ) to end of flash size
+ * @param cpnDataBuf data to be written
+ * @param czDataLen 1 to __EBI_MT25Qx_PAGE_SIZE
+ * @return MROkay, MRFail
+ * @details 
+ * - does not sleep, poll mt25qxChkBusy() to know when programming is done
+ * - cuts off data the same way as mt25qxPageProgram()
+ * @warning
+ * - mt25qxTxPureCfgCmd(cpsThis, MPCCCWriteEnable) is required
+ */
+mt25qxRet_e 
+mt25qxPageProgramStart(
+    mt25qx_s * const cpsThis,
+    const unsigned int cnAddr,
+    const unsigned char * const cpcnDataBuf, 
+    const size_t czDataLen
+);
+
 /**
  * @brief erase operation
  * @param cpsThis pointer to this instance
@@ -276,6 +390,24 @@ mt25qxErase(
     const mt25qxEraseSize_e ceSize
 );
 
+/**
+ * @brief same as mt25qxErase() but returns as soon as the command is sent
+ * @param cpsThis pointer to this instance
+ * @param cnAddr 0x00000000 to end of flash size
+ * @param ceSize 4KB, 32KB, or all = 512Mb = 64MB
+ * @return MROkay, MRFail
+ * @details
+ * - does not sleep, poll mt25qxChkBusy() to know when erasing is done
+ * @warning
+ * - mt25qxTxPureCfgCmd(cpsThis, MPCCCWriteEnable) is required
+ */
+mt25qxRet_e 
+mt25qxEraseStart(
+    mt25qx_s * const cpsThis,
+    const unsigned int cnAddr,
+    const mt25qxEraseSize_e ceSize
+);
+
 /**
  * @brief check if flash is still being page programmed or erased
  * @param cpsThis pointer to this instance
@@ -304,6 +436,124 @@ mt25qxTxPureCfgCmd(
     const mt25qxPureCfgCmdCode_e ceCode
 );
 
+/**
+ * @brief amount of bus clock cycles a command takes
+ * @param cpcsCfgCmd pointer to the command
+ * @return opcode + address + dummy + data cycles, each phase divided by its wire amount
+ */
+unsigned long long
+mt25qxCfgCmdClkCycles(
+    const mt25qxCfgCmd_s * const cpcsCfgCmd
+);
+
+#if defined(__EBI_MT25Qx_METRICS) || defined(__EBI_MT25Qx_TRACE)
+
+/**
+ * @brief set the clock used to measure latencies and to stamp trace records
+ * @param cpsThis pointer to this instance
+ * @param cfTickUs callback function to get a monotonic time in microseconds, NULL to stop timing
+ * @details
+ * - without a clock only the counters and bus cycles are collected, and trace records are stamped 0
+ */
+void
+mt25qxSetClock(
+    mt25qx_s * const cpsThis,
+    const mt25qxTickUs_f cfTickUs
+);
+
+#endif
+
+#ifdef __EBI_MT25Qx_METRICS
+
+/**
+ * @brief take a snapshot of the metrics collected since mt25qxMake() or mt25qxMetricsReset()
+ * @param cpsThis pointer to this instance
+ * @param cpsMetrics pointer to store the snapshot
+ * @return MROkay, MRFail
+ */
+mt25qxRet_e
+mt25qxMetricsGet(
+    mt25qx_s * const cpsThis,
+    mt25qxMetrics_s * const cpsMetrics
+);
+
+/**
+ * @brief clear all metrics of this instance
+ * @param cpsThis pointer to this instance
+ * @return MROkay, MRFail
+ */
+mt25qxRet_e
+mt25qxMetricsReset(
+    mt25qx_s * const cpsThis
+);
+
+/**
+ * @brief write a snapshot as a JSON object
+ * @param cpcsMetrics pointer to the snapshot
+ * @param cpcBuf buffer to store the string, can be NULL if czBufLen is 0
+ * @param czBufLen length of cpcBuf
+ * @return length of the whole JSON string, excluding the terminating NUL
+ * @details
+ * - same as snprintf(): the output is cut off if the returned value >= czBufLen
+ */
+size_t
+mt25qxMetricsDumpJson(
+    const mt25qxMetrics_s * const cpcsMetrics,
+    char * const cpcBuf,
+    const size_t czBufLen
+);
+
+#endif /* __EBI_MT25Qx_METRICS */
+
+#ifdef __EBI_MT25Qx_TRACE
+
+/**
+ * @brief set up an empty trace ring buffer
+ * @param cpsTrace pointer to the trace
+ * @param cpsRecs storage of the records
+ * @param cnCapacity amount of records in cpsRecs
+ * @return MROkay, MRFail
+ */
+mt25qxRet_e
+mt25qxTraceInit(
+    mt25qxTrace_s * const cpsTrace,
+    mt25qxTraceRec_s * const cpsRecs,
+    const unsigned int cnCapacity
+);
+
+/**
+ * @brief start recording every bus action of this instance into a trace
+ * @param cpsThis pointer to this instance
+ * @param cpsTrace pointer to the trace, NULL to stop recording
+ * @warning
+ * - not thread safe: do not dump a trace while it is being recorded
+ */
+void
+mt25qxTraceAttach(
+    mt25qx_s * const cpsThis,
+    mt25qxTrace_s * const cpsTrace
+);
+
+/**
+ * @brief write the records of a trace, oldest first, in the binary trace file format
+ * @param cpcsTrace pointer to the trace
+ * @param cfWrite callback function to write the bytes
+ * @return MROkay, MRFail
+ * @details
+ * - header (__EBI_MT25Qx_TRACE_HEADER_SIZE bytes): magic "M25T", u16 version, u16 record size, 
+ *   u32 record count, u32 records lost by overwriting
+ * - every record (__EBI_MT25Qx_TRACE_RECORD_SIZE bytes): u32 nTimeUs, u32 nAddr, u32 nLen, 
+ *   u8 nKind, u8 nCode, u8 nWires, u8 nDummyClkCycles
+ * - all values are little-endian
+ */
+mt25qxRet_e
+mt25qxTraceDump(
+    const mt25qxTrace_s * const cpcsTrace,
+    const mt25qxTraceWrite_f cfWrite
+);
+
+#endif /* __EBI_MT25Qx_TRACE */
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
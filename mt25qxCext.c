@@ -0,0 +1,480 @@
+#include "mt25qxCext.h"
+#include "mt25qxLz.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define _IN_CHUNK_SIZE ( 4U * __EBI_MT25Qx_PAGE_SIZE )
+#define _ERASE_TIMEOUT_MS 400
+#define _PROGRAM_TIMEOUT_MS 10
+#define _ROUND_UP(nVal, nAlign) ( ( ( (nVal) + (nAlign) - 1 ) / (nAlign) ) * (nAlign) )
+
+struct mt25qxCext_s {
+    mt25qx_s * psFlash;
+    unsigned int nDataAddr;
+    size_t zRawLen;
+    unsigned int nBlocks;
+    unsigned int * pnTable; // ? nBlocks + 1 entries
+    unsigned int nCached; // ? block held by anCache, nBlocks if none
+    unsigned char anCache[__EBI_MT25Qx_CEXT_BLOCK_SIZE];
+    unsigned char anIn[_IN_CHUNK_SIZE];
+};
+
+typedef struct {
+    mt25qx_s * psFlash;
+    mt25qxSrcRead_f fSrcRead;
+    mt25qxCextStat_s sStat;
+    unsigned int nErasedEnd; // ? first address not erased yet
+    unsigned int nWriteAddr; // ? address anPage will be programmed to
+    bool bSrcEnd; // ? the source returned less than asked: never called again
+    size_t zPageLen;
+    unsigned char anPage[__EBI_MT25Qx_PAGE_SIZE];
+    unsigned char anRaw[__EBI_MT25Qx_CEXT_BLOCK_SIZE];
+    unsigned char anComp[__EBI_MT25Qx_CEXT_BLOCK_SIZE];
+    unsigned short anHashTab[__EBI_MT25Qx_LZ_HASH_SIZE];
+} _writer_s;
+
+static
+void
+_putLe32(
+    unsigned char * const cpnBuf,
+    const unsigned int cnVal
+) {
+    cpnBuf[0] = (unsigned char)( cnVal >> 0 );
+    cpnBuf[1] = (unsigned char)( cnVal >> 8 );
+    cpnBuf[2] = (unsigned char)( cnVal >> 16 );
+    cpnBuf[3] = (unsigned char)( cnVal >> 24 );
+}
+
+static
+unsigned int
+_getLe32(
+    const unsigned char * const cpcnBuf
+) {
+    return 
+        ( (unsigned int)cpcnBuf[0] << 0 ) | ( (unsigned int)cpcnBuf[1] << 8 ) | 
+        ( (unsigned int)cpcnBuf[2] << 16 ) | ( (unsigned int)cpcnBuf[3] << 24 );
+}
+
+static
+mt25qxRet_e
+_ensureErased(
+    _writer_s * const cpsThis,
+    const unsigned int cnEndAddr
+) {
+    while ( cnEndAddr > cpsThis->nErasedEnd )
+    {
+        if (
+            MROkay != mt25qxTxPureCfgCmd(cpsThis->psFlash, MPCCCWriteEnable) ||
+            MROkay != mt25qxEraseStart(cpsThis->psFlash, cpsThis->nErasedEnd, MES4KB) ||
+            MRIdle != mt25qxWaitIdle(cpsThis->psFlash, _ERASE_TIMEOUT_MS)
+        ) {
+            return MRFail;
+        }
+
+        cpsThis->nErasedEnd += __EBI_MT25Qx_SUBSECTOR_SIZE;
+        ++cpsThis->sStat.nSectors;
+    }
+
+    return MROkay;
+}
+
+static
+mt25qxRet_e
+_program(
+    _writer_s * const cpsThis,
+    const unsigned int cnAddr,
+    const unsigned char * const cpcnDataBuf,
+    const size_t czDataLen
+) {
+    if (
+        MROkay != _ensureErased(cpsThis, cnAddr + czDataLen) ||
+        MROkay != mt25qxTxPureCfgCmd(cpsThis->psFlash, MPCCCWriteEnable) ||
+        MROkay != mt25qxPageProgramStart(cpsThis->psFlash, cnAddr, cpcnDataBuf, czDataLen) ||
+        MRIdle != mt25qxWaitIdle(cpsThis->psFlash, _PROGRAM_TIMEOUT_MS)
+    ) {
+        return MRFail;
+    }
+
+    ++cpsThis->sStat.nPages;
+    cpsThis->sStat.zStoredLen += czDataLen;
+    return MROkay;
+}
+
+static
+mt25qxRet_e
+_append(
+    _writer_s * const cpsThis,
+    const unsigned char * const cpcnDataBuf,
+    const size_t czDataLen
+) {
+    size_t zPos = 0;
+    size_t zCopy = 0;
+
+    while ( czDataLen > zPos )
+    {
+        zCopy = __EBI_MT25Qx_PAGE_SIZE - cpsThis->zPageLen;
+        zCopy = ( czDataLen - zPos > zCopy ) ? ( zCopy ) : ( czDataLen - zPos );
+
+        memcpy(&cpsThis->anPage[cpsThis->zPageLen], &cpcnDataBuf[zPos], zCopy);
+        cpsThis->zPageLen += zCopy;
+        zPos += zCopy;
+
+        if ( __EBI_MT25Qx_PAGE_SIZE == cpsThis->zPageLen )
+        {
+            if ( MROkay != _program(cpsThis, cpsThis->nWriteAddr, cpsThis->anPage, __EBI_MT25Qx_PAGE_SIZE) )
+            {
+                return MRFail;
+            }
+
+            cpsThis->nWriteAddr += __EBI_MT25Qx_PAGE_SIZE;
+            cpsThis->zPageLen = 0;
+        }
+    }
+
+    return MROkay;
+}
+
+static
+mt25qxRet_e
+_readBlock(
+    _writer_s * const cpsThis,
+    size_t * const cpzLen
+) {
+    size_t zReadLen = 0;
+
+    *cpzLen = 0;
+    while ( false == cpsThis->bSrcEnd && __EBI_MT25Qx_CEXT_BLOCK_SIZE > *cpzLen )
+    {
+        zReadLen = 0;
+        if ( MROkay != cpsThis->fSrcRead(&cpsThis->anRaw[*cpzLen], __EBI_MT25Qx_CEXT_BLOCK_SIZE - *cpzLen, &zReadLen) )
+        {
+            return MRFail;
+        }
+
+        cpsThis->bSrcEnd = ( __EBI_MT25Qx_CEXT_BLOCK_SIZE - *cpzLen > zReadLen ) ? ( true ) : ( false ) ;
+        *cpzLen += zReadLen;
+    }
+
+    return MROkay;
+}
+
+mt25qxRet_e
+mt25qxCextWrite(
+    mt25qx_s * const cpsFlash,
+    const unsigned int cnBaseAddr,
+    const size_t czMaxRawLen,
+    const mt25qxSrcRead_f cfSrcRead,
+    mt25qxCextStat_s * const cpsStat
+) {
+    const size_t czMaxBlocks = _ROUND_UP(czMaxRawLen, __EBI_MT25Qx_CEXT_BLOCK_SIZE) / __EBI_MT25Qx_CEXT_BLOCK_SIZE;
+    const size_t czDataOffset = _ROUND_UP(__EBI_MT25Qx_CEXT_HEADER_SIZE + 4 * ( czMaxBlocks + 1 ), __EBI_MT25Qx_PAGE_SIZE);
+    mt25qxRet_e eRet = MRFail;
+    _writer_s * psWriter = NULL;
+    unsigned char * pnHeader = NULL;
+    size_t zRawLen = 0;
+    size_t zCompLen = 0;
+    size_t zOffset = 0;
+    unsigned int nDataLen = 0;
+
+    if ( NULL == cpsFlash || NULL == cfSrcRead || 0 != ( cnBaseAddr & ( __EBI_MT25Qx_SUBSECTOR_SIZE - 1 ) ) )
+    {
+        return MRFail;
+    }
+
+    psWriter = (_writer_s *)calloc(1, sizeof(_writer_s));
+    pnHeader = (unsigned char *)malloc(czDataOffset);
+    if ( NULL == psWriter || NULL == pnHeader )
+    {
+        goto __exit;
+    }
+
+    memset(pnHeader, 0xFF, czDataOffset);
+    psWriter->psFlash = cpsFlash;
+    psWriter->fSrcRead = cfSrcRead;
+    psWriter->nErasedEnd = cnBaseAddr;
+    psWriter->nWriteAddr = cnBaseAddr + (unsigned int)czDataOffset;
+
+    for ( ;; )
+    {
+        if ( MROkay != _readBlock(psWriter, &zRawLen) )
+        {
+            goto __exit;
+        }
+
+        if ( 0 == zRawLen )
+        {
+            break;
+        }
+
+        if ( czMaxBlocks <= psWriter->sStat.nBlocks )
+        {
+            goto __exit;
+        }
+
+        /* keep it as it is unless compression saves something */
+        zCompLen = mt25qxLzCompress(psWriter->anRaw, zRawLen, psWriter->anComp, zRawLen - 1, psWriter->anHashTab);
+        _putLe32(
+            &pnHeader[__EBI_MT25Qx_CEXT_HEADER_SIZE + 4 * psWriter->sStat.nBlocks], 
+            nDataLen | ( ( 0 == zCompLen ) ? ( __EBI_MT25Qx_CEXT_RAW_FLAG ) : ( 0 ) )
+        );
+
+        if ( 0 == zCompLen )
+        {
+            ++psWriter->sStat.nRawBlocks;
+        }
+
+        if ( 
+            MROkay != _append(
+                psWriter, 
+                ( 0 == zCompLen ) ? ( psWriter->anRaw ) : ( psWriter->anComp ), 
+                ( 0 == zCompLen ) ? ( zRawLen ) : ( zCompLen )
+            ) 
+        ) {
+            goto __exit;
+        }
+
+        nDataLen += (unsigned int)( ( 0 == zCompLen ) ? ( zRawLen ) : ( zCompLen ) );
+        psWriter->sStat.zRawLen += zRawLen;
+        ++psWriter->sStat.nBlocks;
+
+        if ( __EBI_MT25Qx_CEXT_BLOCK_SIZE > zRawLen )
+        {
+            break;
+        }
+    }
+
+    if ( 0 != psWriter->zPageLen && MROkay != _program(psWriter, psWriter->nWriteAddr, psWriter->anPage, psWriter->zPageLen) )
+    {
+        goto __exit;
+    }
+
+    /* header last: an extent cut off by a power loss has no valid magic */
+    _putLe32(&pnHeader[__EBI_MT25Qx_CEXT_HEADER_SIZE + 4 * psWriter->sStat.nBlocks], nDataLen);
+    memcpy(&pnHeader[0], __EBI_MT25Qx_CEXT_MAGIC, 4);
+    _putLe32(&pnHeader[4], __EBI_MT25Qx_CEXT_BLOCK_SIZE);
+    _putLe32(&pnHeader[8], (unsigned int)psWriter->sStat.zRawLen);
+    _putLe32(&pnHeader[12], psWriter->sStat.nBlocks);
+    _putLe32(&pnHeader[16], (unsigned int)czDataOffset);
+
+    for ( zOffset = 0; __EBI_MT25Qx_CEXT_HEADER_SIZE + 4 * ( psWriter->sStat.nBlocks + 1 ) > zOffset; zOffset += __EBI_MT25Qx_PAGE_SIZE )
+    {
+        if ( MROkay != _program(psWriter, cnBaseAddr + (unsigned int)zOffset, &pnHeader[zOffset], __EBI_MT25Qx_PAGE_SIZE) )
+        {
+            goto __exit;
+        }
+    }
+
+    eRet = MROkay;
+
+__exit:
+    if ( NULL != cpsStat && NULL != psWriter )
+    {
+        memcpy(cpsStat, &psWriter->sStat, sizeof(mt25qxCextStat_s));
+    }
+
+    free(pnHeader);
+    free(psWriter);
+    return eRet;
+}
+
+mt25qxCext_s *
+mt25qxCextOpen(
+    mt25qx_s * const cpsFlash,
+    const unsigned int cnBaseAddr
+) {
+    unsigned char anHeader[__EBI_MT25Qx_CEXT_HEADER_SIZE] = {0};
+    unsigned char * pnTable = NULL;
+    mt25qxCext_s * psThis = NULL;
+    unsigned int nDataOffset = 0;
+    unsigned int nIdx = 0;
+
+    if ( 
+        NULL == cpsFlash ||
+        MROkay != mt25qxFastRead(cpsFlash, cnBaseAddr, anHeader, sizeof(anHeader)) ||
+        0 != memcmp(anHeader, __EBI_MT25Qx_CEXT_MAGIC, 4) ||
+        __EBI_MT25Qx_CEXT_BLOCK_SIZE != _getLe32(&anHeader[4])
+    ) {
+        return NULL;
+    }
+
+    psThis = (mt25qxCext_s *)calloc(1, sizeof(mt25qxCext_s));
+    if ( NULL == psThis )
+    {
+        return NULL;
+    }
+
+    psThis->psFlash = cpsFlash;
+    psThis->zRawLen = _getLe32(&anHeader[8]);
+    psThis->nBlocks = _getLe32(&anHeader[12]);
+    psThis->nCached = psThis->nBlocks;
+    nDataOffset = _getLe32(&anHeader[16]);
+    psThis->nDataAddr = cnBaseAddr + nDataOffset;
+
+    if ( 
+        _ROUND_UP(psThis->zRawLen, __EBI_MT25Qx_CEXT_BLOCK_SIZE) / __EBI_MT25Qx_CEXT_BLOCK_SIZE != psThis->nBlocks ||
+        __EBI_MT25Qx_CEXT_HEADER_SIZE + 4 * ( (size_t)psThis->nBlocks + 1 ) > nDataOffset
+    ) {
+        goto __error;
+    }
+
+    pnTable = (unsigned char *)malloc(__EBI_MT25Qx_CEXT_HEADER_SIZE + 4 * ( (size_t)psThis->nBlocks + 1 ));
+    psThis->pnTable = (unsigned int *)calloc(psThis->nBlocks + 1, sizeof(unsigned int));
+    if ( 
+        NULL == pnTable || NULL == psThis->pnTable ||
+        MROkay != mt25qxFastRead(cpsFlash, cnBaseAddr, pnTable, __EBI_MT25Qx_CEXT_HEADER_SIZE + 4 * ( (size_t)psThis->nBlocks + 1 ))
+    ) {
+        goto __error;
+    }
+
+    for ( nIdx = 0; psThis->nBlocks >= nIdx; ++nIdx )
+    {
+        psThis->pnTable[nIdx] = _getLe32(&pnTable[__EBI_MT25Qx_CEXT_HEADER_SIZE + 4 * nIdx]);
+        if ( 
+            0 < nIdx && 
+            ( psThis->pnTable[nIdx] & ~__EBI_MT25Qx_CEXT_RAW_FLAG ) < ( psThis->pnTable[nIdx - 1] & ~__EBI_MT25Qx_CEXT_RAW_FLAG ) 
+        ) {
+            goto __error;
+        }
+    }
+
+    free(pnTable);
+    return psThis;
+
+__error:
+    free(pnTable);
+    mt25qxCextClose(psThis);
+    return NULL;
+}
+
+void
+mt25qxCextClose(
+    void * pvThis
+) {
+    mt25qxCext_s * const cpsThis = (mt25qxCext_s *)pvThis;
+
+    if ( NULL == cpsThis )
+    {
+        return;
+    }
+
+    free(cpsThis->pnTable);
+    free(cpsThis);
+}
+
+size_t
+mt25qxCextRawLen(
+    const mt25qxCext_s * const cpcsThis
+) {
+    return ( NULL == cpcsThis ) ? ( 0 ) : ( cpcsThis->zRawLen ) ;
+}
+
+/**
+ * @brief stream one block from flash through the decoder into cpnOut
+ */
+static
+mt25qxRet_e
+_decodeBlock(
+    mt25qxCext_s * const cpsThis,
+    const unsigned int cnBlock,
+    unsigned char * const cpnOut,
+    const size_t czRawLen
+) {
+    const unsigned int cnStart = cpsThis->pnTable[cnBlock] & ~__EBI_MT25Qx_CEXT_RAW_FLAG;
+    const unsigned int cnEnd = cpsThis->pnTable[cnBlock + 1] & ~__EBI_MT25Qx_CEXT_RAW_FLAG;
+    const bool cbIsRaw = ( 0 != ( cpsThis->pnTable[cnBlock] & __EBI_MT25Qx_CEXT_RAW_FLAG ) ) ? ( true ) : ( false ) ;
+    mt25qxLzDec_s sDec;
+    unsigned int nAddr = ( cpsThis->nDataAddr + cnStart ) & ~( __EBI_MT25Qx_PAGE_SIZE - 1 );
+    size_t zSkip = ( cpsThis->nDataAddr + cnStart ) - nAddr;
+    size_t zLeft = ( cnEnd - cnStart ) + zSkip;
+    size_t zRaw = 0;
+    size_t zChunk = 0;
+
+    if ( true == cbIsRaw && cnEnd - cnStart != czRawLen )
+    {
+        return MRFail;
+    }
+
+    mt25qxLzDecInit(&sDec, cpnOut, czRawLen);
+
+    /* mt25qxFastRead() wants page aligned addresses: skip the head of the first page */
+    for ( ; 0 < zLeft; nAddr += (unsigned int)zChunk, zLeft -= zChunk, zSkip = 0 )
+    {
+        zChunk = ( zLeft > _IN_CHUNK_SIZE ) ? ( _IN_CHUNK_SIZE ) : ( zLeft );
+        if ( MROkay != mt25qxFastRead(cpsThis->psFlash, nAddr, cpsThis->anIn, zChunk) )
+        {
+            return MRFail;
+        }
+
+        if ( true == cbIsRaw )
+        {
+            memcpy(&cpnOut[zRaw], &cpsThis->anIn[zSkip], zChunk - zSkip);
+            zRaw += zChunk - zSkip;
+        }
+        else if ( MROkay != mt25qxLzDecFeed(&sDec, &cpsThis->anIn[zSkip], zChunk - zSkip) )
+        {
+            return MRFail;
+        }
+    }
+
+    if ( true == cbIsRaw )
+    {
+        return MROkay;
+    }
+
+    return ( MROkay == mt25qxLzDecEnd(&sDec) && czRawLen == sDec.zOutLen ) ? ( MROkay ) : ( MRFail ) ;
+}
+
+mt25qxRet_e
+mt25qxCextRead(
+    mt25qxCext_s * const cpsThis,
+    const size_t czOffset,
+    unsigned char * const cpnDataBuf,
+    const size_t czDataLen
+) {
+    size_t zOffset = czOffset;
+    size_t zDone = 0;
+    size_t zInBlock = 0;
+    size_t zBlockLen = 0;
+    size_t zCopy = 0;
+    unsigned int nBlock = 0;
+
+    if ( NULL == cpsThis || NULL == cpnDataBuf || czOffset > cpsThis->zRawLen || czDataLen > cpsThis->zRawLen - czOffset )
+    {
+        return MRFail;
+    }
+
+    for ( ; czDataLen > zDone; zDone += zCopy, zOffset += zCopy )
+    {
+        nBlock = (unsigned int)( zOffset / __EBI_MT25Qx_CEXT_BLOCK_SIZE );
+        zInBlock = zOffset % __EBI_MT25Qx_CEXT_BLOCK_SIZE;
+        zBlockLen = cpsThis->zRawLen - (size_t)nBlock * __EBI_MT25Qx_CEXT_BLOCK_SIZE;
+        zBlockLen = ( zBlockLen > __EBI_MT25Qx_CEXT_BLOCK_SIZE ) ? ( __EBI_MT25Qx_CEXT_BLOCK_SIZE ) : ( zBlockLen );
+        zCopy = ( czDataLen - zDone > zBlockLen - zInBlock ) ? ( zBlockLen - zInBlock ) : ( czDataLen - zDone );
+
+        if ( nBlock == cpsThis->nCached )
+        {
+            memcpy(&cpnDataBuf[zDone], &cpsThis->anCache[zInBlock], zCopy);
+            continue;
+        }
+
+        if ( 0 == zInBlock && zBlockLen == zCopy )
+        {
+            if ( MROkay != _decodeBlock(cpsThis, nBlock, &cpnDataBuf[zDone], zBlockLen) )
+            {
+                return MRFail;
+            }
+            continue;
+        }
+
+        cpsThis->nCached = cpsThis->nBlocks;
+        if ( MROkay != _decodeBlock(cpsThis, nBlock, cpsThis->anCache, zBlockLen) )
+        {
+            return MRFail;
+        }
+
+        cpsThis->nCached = nBlock;
+        memcpy(&cpnDataBuf[zDone], &cpsThis->anCache[zInBlock], zCopy);
+    }
+
+    return MROkay;
+}
@@ -0,0 +1,111 @@
+#ifndef __EBI_MT25Qx_CEXT_H
+#define __EBI_MT25Qx_CEXT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include "mt25qx.h"
+
+#define __EBI_MT25Qx_CEXT_MAGIC "M25Z"
+#define __EBI_MT25Qx_CEXT_BLOCK_SIZE 4096U
+#define __EBI_MT25Qx_CEXT_HEADER_SIZE 20U
+#define __EBI_MT25Qx_CEXT_RAW_FLAG 0x80000000U
+
+typedef struct mt25qxCext_s mt25qxCext_s;
+
+typedef struct {
+    size_t zRawLen; // ? bytes read from the source
+    size_t zStoredLen; // ? bytes programmed: header, seek table and blocks
+    unsigned int nBlocks;
+    unsigned int nRawBlocks; // ? blocks which did not compress and are stored as they are
+    unsigned int nPages; // ? pages programmed
+    unsigned int nSectors; // ? 4KB subsectors erased
+} mt25qxCextStat_s;
+
+/**
+ * @brief compress a source image into a compressed extent
+ * @param cpsFlash pointer to a mt25qx_s instance
+ * @param cnBaseAddr 0x00000000 + ( N * __EBI_MT25Qx_SUBSECTOR_SIZE )
+ * @param czMaxRawLen the largest image this extent has to hold, sizes the seek table
+ * @param cfSrcRead callback function to read the source image
+ * @param cpsStat pointer to store the statistics, can be NULL
+ * @return MROkay, MRFail
+ * @details
+ * - layout: header, seek table, then every 4KB of the source as an independent LZ4 block
+ * - header (__EBI_MT25Qx_CEXT_HEADER_SIZE bytes): magic "M25Z", u32 block size, u32 raw length,
+ *   u32 block count, u32 offset of the first block
+ * - seek table: block count + 1 u32 offsets from the first block, __EBI_MT25Qx_CEXT_RAW_FLAG 
+ *   marks a block stored without compression; the last one is the end of the data
+ * - all values are little-endian
+ * - only the subsectors the extent ends up using are erased
+ * @warning
+ * - return MRFail if the source is longer than czMaxRawLen
+ */
+mt25qxRet_e
+mt25qxCextWrite(
+    mt25qx_s * const cpsFlash,
+    const unsigned int cnBaseAddr,
+    const size_t czMaxRawLen,
+    const mt25qxSrcRead_f cfSrcRead,
+    mt25qxCextStat_s * const cpsStat
+);
+
+/**
+ * @brief open a compressed extent for reading via dynamic memory
+ * @param cpsFlash pointer to a mt25qx_s instance
+ * @param cnBaseAddr address given to mt25qxCextWrite()
+ * @return pointer to this extent, NULL if there is no valid extent at cnBaseAddr
+ */
+mt25qxCext_s *
+mt25qxCextOpen(
+    mt25qx_s * const cpsFlash,
+    const unsigned int cnBaseAddr
+);
+
+/**
+ * @brief free dynamic memory
+ * @param pvThis pointer to this extent
+ */
+void
+mt25qxCextClose(
+    void * pvThis
+);
+
+/**
+ * @brief length of the image before compression
+ * @param cpcsThis pointer to this extent
+ * @return raw length
+ */
+size_t
+mt25qxCextRawLen(
+    const mt25qxCext_s * const cpcsThis
+);
+
+/**
+ * @brief read decompressed data from anywhere in the image
+ * @param cpsThis pointer to this extent
+ * @param czOffset offset in the image before compression
+ * @param cpnDataBuf store data to be read
+ * @param czDataLen would like to receive length
+ * @return MROkay, MRFail
+ * @details
+ * - compressed data is read in small pieces and decompressed as it arrives
+ * - blocks fully covered by the request are decompressed straight into cpnDataBuf,
+ *   partly covered ones go through a one block cache
+ * @warning
+ * - return MRFail if czOffset + czDataLen is beyond the raw length
+ */
+mt25qxRet_e
+mt25qxCextRead(
+    mt25qxCext_s * const cpsThis,
+    const size_t czOffset,
+    unsigned char * const cpnDataBuf,
+    const size_t czDataLen
+);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __EBI_MT25Qx_CEXT_H */
@@ -0,0 +1,32 @@
+#ifndef __EBI_MT25Qx_CRC_H
+#define __EBI_MT25Qx_CRC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include <stddef.h>
+
+/**
+ * @brief CRC32C (Castagnoli) over N bytes, continuing from a previous result
+ * @param cnCrc 0 to start, or the value returned by the previous call
+ * @param cpcnDataBuf data to be checksummed
+ * @param czDataLen length of cpcnDataBuf
+ * @return updated CRC32C value
+ * @details
+ * - uses the SSE4.2 crc32 instruction if built with __SSE4_2__ (e.g. -msse4.2)
+ * - uses the ARMv8 crc32c instruction if built with __ARM_FEATURE_CRC32 (e.g. -march=armv8-a+crc)
+ * - otherwise falls back to a byte-wise lookup table
+ */
+unsigned int
+mt25qxCrc32c(
+    const unsigned int cnCrc,
+    const unsigned char * const cpcnDataBuf,
+    const size_t czDataLen
+);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __EBI_MT25Qx_CRC_H */
@@ -0,0 +1,259 @@
+#include "mt25qxFlasher.h"
+#include "mt25qxCrc.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define _PAGES_PER_CHUNK ( __EBI_MT25Qx_SUBSECTOR_SIZE / __EBI_MT25Qx_PAGE_SIZE )
+#define _ERASE_TIMEOUT_MS 400
+#define _PROGRAM_TIMEOUT_MS 10
+
+typedef struct {
+    unsigned char anData[__EBI_MT25Qx_SUBSECTOR_SIZE];
+    unsigned int anPageCrc[_PAGES_PER_CHUNK];
+    size_t zLen;
+    bool bLoaded;
+} _chunk_s;
+
+typedef struct {
+    mt25qx_s * psFlash;
+    mt25qxSrcRead_f fSrcRead;
+    mt25qxFlashStat_s sStat;
+    bool bSrcEnd;
+    _chunk_s asChunk[2];
+
+    struct {
+        unsigned char anData[__EBI_MT25Qx_PAGE_SIZE];
+        unsigned int nAddr;
+        size_t zLen;
+        unsigned int nCrc;
+        bool bPending;
+    } sVerify;
+
+} _flasher_s;
+
+static
+mt25qxRet_e
+_loadChunk(
+    _flasher_s * const cpsThis,
+    _chunk_s * const cpsChunk
+) {
+    mt25qxRet_e eRet = MROkay;
+    size_t zReadLen = 0;
+    size_t zOffset = 0;
+    unsigned int nPage = 0;
+
+    cpsChunk->zLen = 0;
+
+    while ( false == cpsThis->bSrcEnd && __EBI_MT25Qx_SUBSECTOR_SIZE > cpsChunk->zLen )
+    {
+        zReadLen = 0;
+        eRet = cpsThis->fSrcRead(
+            &cpsChunk->anData[cpsChunk->zLen], 
+            __EBI_MT25Qx_SUBSECTOR_SIZE - cpsChunk->zLen, 
+            &zReadLen
+        );
+        if ( MROkay != eRet )
+        {
+            return MRFail;
+        }
+
+        cpsThis->bSrcEnd = ( __EBI_MT25Qx_SUBSECTOR_SIZE - cpsChunk->zLen > zReadLen ) ? ( true ) : ( false ) ;
+        cpsChunk->zLen += zReadLen;
+    }
+
+    for ( nPage = 0, zOffset = 0; cpsChunk->zLen > zOffset; ++nPage, zOffset += __EBI_MT25Qx_PAGE_SIZE )
+    {
+        cpsChunk->anPageCrc[nPage] = mt25qxCrc32c(
+            0, 
+            &cpsChunk->anData[zOffset], 
+            ( cpsChunk->zLen - zOffset > __EBI_MT25Qx_PAGE_SIZE ) ? ( __EBI_MT25Qx_PAGE_SIZE ) : ( cpsChunk->zLen - zOffset )
+        );
+    }
+
+    cpsThis->sStat.nImageCrc = mt25qxCrc32c(cpsThis->sStat.nImageCrc, cpsChunk->anData, cpsChunk->zLen);
+    cpsThis->sStat.zImageLen += cpsChunk->zLen;
+    cpsChunk->bLoaded = true;
+    return MROkay;
+}
+
+static
+void
+_verifyPage(
+    _flasher_s * const cpsThis
+) {
+    if ( false == cpsThis->sVerify.bPending )
+    {
+        return;
+    }
+
+    cpsThis->sVerify.bPending = false;
+    if ( cpsThis->sVerify.nCrc != mt25qxCrc32c(0, cpsThis->sVerify.anData, cpsThis->sVerify.zLen) )
+    {
+        if ( 0 == cpsThis->sStat.nVerifyErrs++ )
+        {
+            cpsThis->sStat.nFirstErrAddr = cpsThis->sVerify.nAddr;
+        }
+    }
+}
+
+/**
+ * @return MROkay: one job done, MRIdle: nothing left to do, MRFail: source error
+ */
+static
+mt25qxRet_e
+_hideJob(
+    _flasher_s * const cpsThis,
+    _chunk_s * const cpsNext
+) {
+    if ( true == cpsThis->sVerify.bPending )
+    {
+        _verifyPage(cpsThis);
+        return MROkay;
+    }
+
+    if ( false == cpsNext->bLoaded )
+    {
+        return _loadChunk(cpsThis, cpsNext);
+    }
+
+    return MRIdle;
+}
+
+static
+mt25qxRet_e
+_waitIdle(
+    _flasher_s * const cpsThis,
+    _chunk_s * const cpsNext,
+    const unsigned int cnTimeoutMs
+) {
+    mt25qxRet_e eRet = MROkay;
+    unsigned int nTryTimes = cnTimeoutMs;
+
+    for ( ;; )
+    {
+        eRet = _hideJob(cpsThis, cpsNext);
+        if ( MROkay == eRet )
+        {
+            ++cpsThis->sStat.nHiddenJobs;
+            eRet = mt25qxChkBusy(cpsThis->psFlash);
+        }
+        else if ( MRIdle == eRet )
+        {
+            if ( 0 == nTryTimes-- )
+            {
+                return MRBusy;
+            }
+
+            ++cpsThis->sStat.nIdlePolls;
+            eRet = mt25qxWaitIdle(cpsThis->psFlash, 1);
+        }
+
+        if ( MRBusy != eRet )
+        {
+            return eRet;
+        }
+    }
+}
+
+mt25qxRet_e
+mt25qxFlashImage(
+    mt25qx_s * const cpsThis,
+    const unsigned int cnAddr,
+    const mt25qxSrcRead_f cfSrcRead,
+    mt25qxFlashStat_s * const cpsStat
+) {
+    mt25qxRet_e eRet = MRFail;
+    _flasher_s * psFlasher = NULL;
+    _chunk_s * psCur = NULL;
+    _chunk_s * psNext = NULL;
+    unsigned int nAddr = cnAddr;
+    unsigned int nCur = 0;
+    size_t zOffset = 0;
+    size_t zPageLen = 0;
+
+    if ( NULL == cpsThis || NULL == cfSrcRead )
+    {
+        return MRFail;
+    }
+
+    if ( 0 != ( cnAddr & ( __EBI_MT25Qx_SUBSECTOR_SIZE - 1 ) ) )
+    {
+        return MRFail;
+    }
+
+    psFlasher = (_flasher_s *)calloc(1, sizeof(_flasher_s));
+    if ( NULL == psFlasher )
+    {
+        return MRFail;
+    }
+
+    psFlasher->psFlash = cpsThis;
+    psFlasher->fSrcRead = cfSrcRead;
+
+    if ( MROkay != _loadChunk(psFlasher, &psFlasher->asChunk[0]) )
+    {
+        goto __exit;
+    }
+
+    for ( nCur = 0; 0 < psFlasher->asChunk[nCur].zLen; nCur ^= 1, nAddr += __EBI_MT25Qx_SUBSECTOR_SIZE )
+    {
+        psCur = &psFlasher->asChunk[nCur];
+        psNext = &psFlasher->asChunk[nCur ^ 1];
+
+        if (
+            MROkay != mt25qxTxPureCfgCmd(cpsThis, MPCCCWriteEnable) ||
+            MROkay != mt25qxEraseStart(cpsThis, nAddr, MES4KB) ||
+            MRIdle != _waitIdle(psFlasher, psNext, _ERASE_TIMEOUT_MS)
+        ) {
+            goto __exit;
+        }
+
+        ++psFlasher->sStat.nSectors;
+
+        for ( zOffset = 0; psCur->zLen > zOffset; zOffset += __EBI_MT25Qx_PAGE_SIZE )
+        {
+            zPageLen = ( psCur->zLen - zOffset > __EBI_MT25Qx_PAGE_SIZE ) ? ( __EBI_MT25Qx_PAGE_SIZE ) : ( psCur->zLen - zOffset );
+
+            if (
+                MROkay != mt25qxTxPureCfgCmd(cpsThis, MPCCCWriteEnable) ||
+                MROkay != mt25qxPageProgramStart(cpsThis, nAddr + zOffset, &psCur->anData[zOffset], zPageLen) ||
+                MRIdle != _waitIdle(psFlasher, psNext, _PROGRAM_TIMEOUT_MS)
+            ) {
+                goto __exit;
+            }
+
+            ++psFlasher->sStat.nPages;
+
+            /* the read-back is checked while the next page is being programmed */
+            _verifyPage(psFlasher);
+            if ( MROkay != mt25qxFastRead(cpsThis, nAddr + zOffset, psFlasher->sVerify.anData, zPageLen) )
+            {
+                goto __exit;
+            }
+
+            psFlasher->sVerify.nAddr = nAddr + zOffset;
+            psFlasher->sVerify.zLen = zPageLen;
+            psFlasher->sVerify.nCrc = psCur->anPageCrc[zOffset / __EBI_MT25Qx_PAGE_SIZE];
+            psFlasher->sVerify.bPending = true;
+        }
+
+        /* the flash was faster than the source: nothing left to hide behind */
+        psCur->bLoaded = false;
+        if ( false == psNext->bLoaded && MROkay != _loadChunk(psFlasher, psNext) )
+        {
+            goto __exit;
+        }
+    }
+
+    _verifyPage(psFlasher);
+    eRet = ( 0 == psFlasher->sStat.nVerifyErrs ) ? ( MROkay ) : ( MRFail ) ;
+
+__exit:
+    if ( NULL != cpsStat )
+    {
+        memcpy(cpsStat, &psFlasher->sStat, sizeof(mt25qxFlashStat_s));
+    }
+
+    free(psFlasher);
+    return eRet;
+}
@@ -0,0 +1,50 @@
+#ifndef __EBI_MT25Qx_FLASHER_H
+#define __EBI_MT25Qx_FLASHER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include "mt25qx.h"
+
+typedef struct {
+    size_t zImageLen; // ? bytes read from the source and programmed
+    unsigned int nImageCrc; // ? CRC32C of the whole source image
+    unsigned int nSectors; // ? 4KB subsectors erased
+    unsigned int nPages; // ? pages programmed
+    unsigned int nVerifyErrs; // ? pages whose read-back CRC32C does not match the source
+    unsigned int nFirstErrAddr; // ? address of the first mismatched page, only valid if nVerifyErrs > 0
+    unsigned int nHiddenJobs; // ? source reads and verifies done while the flash was busy
+    unsigned int nIdlePolls; // ? 1ms waits taken because nothing was left to overlap
+} mt25qxFlashStat_s;
+
+/**
+ * @brief stream a source image into flash: erase, program and verify in a pipeline
+ * @param cpsThis pointer to a mt25qx_s instance
+ * @param cnAddr 0x00000000 + ( N * __EBI_MT25Qx_SUBSECTOR_SIZE ) to end of flash size
+ * @param cfSrcRead callback function to read the source image
+ * @param cpsStat pointer to store the statistics, can be NULL
+ * @return MROkay, MRFail
+ * @details
+ * - the source is read in 4KB chunks into two buffers: while one chunk is erased and
+ *   programmed, the next one is read and checksummed
+ * - every programmed page is read back right after it completes, and its CRC32C is
+ *   checked while the following page is being programmed
+ * - return MRFail if any page does not verify, cpsStat tells which one
+ * @warning
+ * - every 4KB subsector touched by the image is erased
+ * - this function will sleep this thread when there is nothing to do but waiting
+ */
+mt25qxRet_e
+mt25qxFlashImage(
+    mt25qx_s * const cpsThis,
+    const unsigned int cnAddr,
+    const mt25qxSrcRead_f cfSrcRead,
+    mt25qxFlashStat_s * const cpsStat
+);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __EBI_MT25Qx_FLASHER_H */
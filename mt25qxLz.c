@@ -0,0 +1,312 @@
+#include "mt25qxLz.h"
+#include <string.h>
+
+#define _MIN_MATCH 4U
+#define _LAST_LITERALS 5U
+#define _MF_LIMIT 12U
+
+typedef enum {
+    _DSToken,
+    _DSLitLenExt,
+    _DSLiterals,
+    _DSOffsetLo,
+    _DSOffsetHi,
+    _DSMatchLenExt
+} _decState_e;
+
+static
+unsigned int
+_read32(
+    const unsigned char * const cpcnSrc
+) {
+    unsigned int nVal = 0;
+
+    memcpy(&nVal, cpcnSrc, sizeof(nVal));
+    return nVal;
+}
+
+static
+unsigned int
+_hash(
+    const unsigned int cnVal
+) {
+    return ( cnVal * 2654435761U ) >> ( 32 - 12 ); // ? 12 bits: __EBI_MT25Qx_LZ_HASH_SIZE
+}
+
+/**
+ * @brief write a 15 + 255 + 255 + ... length extension
+ */
+static
+bool
+_putLenExt(
+    unsigned char * const cpnDst,
+    const size_t czDstCap,
+    size_t * const cpzPos,
+    size_t zLen
+) {
+    for ( ; zLen >= 255; zLen -= 255 )
+    {
+        if ( czDstCap <= *cpzPos )
+        {
+            return false;
+        }
+
+        cpnDst[( *cpzPos )++] = 255;
+    }
+
+    if ( czDstCap <= *cpzPos )
+    {
+        return false;
+    }
+
+    cpnDst[( *cpzPos )++] = (unsigned char)zLen;
+    return true;
+}
+
+static
+bool
+_putSequence(
+    unsigned char * const cpnDst,
+    const size_t czDstCap,
+    size_t * const cpzPos,
+    const unsigned char * const cpcnLit,
+    const size_t czLitLen,
+    const unsigned int cnOffset,
+    const size_t czMatchLen
+) {
+    const size_t czMatchCode = ( 0 == czMatchLen ) ? ( 0 ) : ( czMatchLen - _MIN_MATCH );
+    size_t zToken = *cpzPos;
+
+    if ( czDstCap <= *cpzPos )
+    {
+        return false;
+    }
+
+    cpnDst[zToken] = (unsigned char)(
+        ( ( ( czLitLen >= 15 ) ? ( 15 ) : ( czLitLen ) ) << 4 ) | 
+        ( ( czMatchCode >= 15 ) ? ( 15 ) : ( czMatchCode ) )
+    );
+    ++*cpzPos;
+
+    if ( czLitLen >= 15 && false == _putLenExt(cpnDst, czDstCap, cpzPos, czLitLen - 15) )
+    {
+        return false;
+    }
+
+    if ( czDstCap - *cpzPos < czLitLen )
+    {
+        return false;
+    }
+
+    memcpy(&cpnDst[*cpzPos], cpcnLit, czLitLen);
+    *cpzPos += czLitLen;
+
+    /* the last sequence has literals only */
+    if ( 0 == czMatchLen )
+    {
+        return true;
+    }
+
+    if ( czDstCap - *cpzPos < 2 )
+    {
+        return false;
+    }
+
+    cpnDst[( *cpzPos )++] = (unsigned char)( cnOffset & 0xFF );
+    cpnDst[( *cpzPos )++] = (unsigned char)( cnOffset >> 8 );
+
+    return ( czMatchCode >= 15 ) ? ( _putLenExt(cpnDst, czDstCap, cpzPos, czMatchCode - 15) ) : ( true ) ;
+}
+
+size_t
+mt25qxLzCompress(
+    const unsigned char * const cpcnSrc,
+    const size_t czSrcLen,
+    unsigned char * const cpnDst,
+    const size_t czDstCap,
+    unsigned short * const cpnHashTab
+) {
+    size_t zPos = 0;
+    size_t zIp = 0;
+    size_t zAnchor = 0;
+    size_t zRef = 0;
+    size_t zMatchLen = 0;
+    unsigned int nHash = 0;
+
+    if ( 
+        NULL == cpcnSrc || NULL == cpnDst || NULL == cpnHashTab || 
+        0 == czSrcLen || __EBI_MT25Qx_LZ_MAX_OFFSET < czSrcLen 
+    ) {
+        return 0;
+    }
+
+    /* entries hold position + 1, 0 means empty */
+    memset(cpnHashTab, 0, __EBI_MT25Qx_LZ_HASH_SIZE * sizeof(unsigned short));
+
+    while ( czSrcLen > _MF_LIMIT && czSrcLen - _MF_LIMIT > zIp )
+    {
+        nHash = _hash(_read32(&cpcnSrc[zIp]));
+        zRef = cpnHashTab[nHash];
+        cpnHashTab[nHash] = (unsigned short)( zIp + 1 );
+
+        if ( 0 == zRef-- || _read32(&cpcnSrc[zRef]) != _read32(&cpcnSrc[zIp]) )
+        {
+            ++zIp;
+            continue;
+        }
+
+        for ( 
+            zMatchLen = _MIN_MATCH; 
+            czSrcLen - _LAST_LITERALS > zIp + zMatchLen && cpcnSrc[zRef + zMatchLen] == cpcnSrc[zIp + zMatchLen]; 
+            ++zMatchLen 
+        ) {}
+
+        if ( false == _putSequence(cpnDst, czDstCap, &zPos, &cpcnSrc[zAnchor], zIp - zAnchor, (unsigned int)( zIp - zRef ), zMatchLen) )
+        {
+            return 0;
+        }
+
+        zIp += zMatchLen;
+        zAnchor = zIp;
+    }
+
+    if ( false == _putSequence(cpnDst, czDstCap, &zPos, &cpcnSrc[zAnchor], czSrcLen - zAnchor, 0, 0) )
+    {
+        return 0;
+    }
+
+    return zPos;
+}
+
+void
+mt25qxLzDecInit(
+    mt25qxLzDec_s * const cpsDec,
+    unsigned char * const cpnOut,
+    const size_t czOutCap
+) {
+    if ( NULL == cpsDec )
+    {
+        return;
+    }
+
+    memset(cpsDec, 0, sizeof(mt25qxLzDec_s));
+    cpsDec->pnOut = cpnOut;
+    cpsDec->zOutCap = czOutCap;
+    cpsDec->nState = _DSToken;
+}
+
+static
+mt25qxRet_e
+_copyMatch(
+    mt25qxLzDec_s * const cpsDec
+) {
+    size_t zIdx = 0;
+
+    if ( 
+        0 == cpsDec->nOffset || cpsDec->zOutLen < cpsDec->nOffset || 
+        cpsDec->zOutCap - cpsDec->zOutLen < cpsDec->zMatchLen 
+    ) {
+        return MRFail;
+    }
+
+    /* byte by byte: the match may overlap what it produces */
+    for ( zIdx = 0; cpsDec->zMatchLen > zIdx; ++zIdx, ++cpsDec->zOutLen )
+    {
+        cpsDec->pnOut[cpsDec->zOutLen] = cpsDec->pnOut[cpsDec->zOutLen - cpsDec->nOffset];
+    }
+
+    cpsDec->nState = _DSToken;
+    return MROkay;
+}
+
+mt25qxRet_e
+mt25qxLzDecFeed(
+    mt25qxLzDec_s * const cpsDec,
+    const unsigned char * const cpcnIn,
+    const size_t czInLen
+) {
+    size_t zPos = 0;
+    size_t zCopy = 0;
+    unsigned char nByte = 0;
+
+    if ( NULL == cpsDec || ( NULL == cpcnIn && 0 != czInLen ) )
+    {
+        return MRFail;
+    }
+
+    while ( czInLen > zPos )
+    {
+        if ( _DSLiterals == cpsDec->nState )
+        {
+            zCopy = ( czInLen - zPos > cpsDec->zLitLen ) ? ( cpsDec->zLitLen ) : ( czInLen - zPos );
+            if ( cpsDec->zOutCap - cpsDec->zOutLen < zCopy )
+            {
+                return MRFail;
+            }
+
+            memcpy(&cpsDec->pnOut[cpsDec->zOutLen], &cpcnIn[zPos], zCopy);
+            cpsDec->zOutLen += zCopy;
+            cpsDec->zLitLen -= zCopy;
+            zPos += zCopy;
+
+            if ( 0 == cpsDec->zLitLen )
+            {
+                cpsDec->nState = _DSOffsetLo;
+            }
+            continue;
+        }
+
+        nByte = cpcnIn[zPos++];
+        switch ( cpsDec->nState )
+        {
+        case _DSToken:
+            cpsDec->zLitLen = nByte >> 4;
+            cpsDec->zMatchLen = ( nByte & 0x0F ) + _MIN_MATCH;
+            cpsDec->nState = ( 15 == cpsDec->zLitLen ) ? ( _DSLitLenExt ) : ( ( 0 == cpsDec->zLitLen ) ? ( _DSOffsetLo ) : ( _DSLiterals ) );
+            break;
+
+        case _DSLitLenExt:
+            cpsDec->zLitLen += nByte;
+            if ( 255 != nByte )
+            {
+                cpsDec->nState = _DSLiterals;
+            }
+            break;
+
+        case _DSOffsetLo:
+            cpsDec->nOffset = nByte;
+            cpsDec->nState = _DSOffsetHi;
+            break;
+
+        case _DSOffsetHi:
+            cpsDec->nOffset |= (unsigned int)nByte << 8;
+            if ( 15 + _MIN_MATCH == cpsDec->zMatchLen )
+            {
+                cpsDec->nState = _DSMatchLenExt;
+            }
+            else if ( MROkay != _copyMatch(cpsDec) )
+            {
+                return MRFail;
+            }
+            break;
+
+        default: /* _DSMatchLenExt */
+            cpsDec->zMatchLen += nByte;
+            if ( 255 != nByte && MROkay != _copyMatch(cpsDec) )
+            {
+                return MRFail;
+            }
+            break;
+        }
+    }
+
+    return MROkay;
+}
+
+mt25qxRet_e
+mt25qxLzDecEnd(
+    const mt25qxLzDec_s * const cpcsDec
+) {
+    /* a block ends right after the literals of its last sequence */
+    return ( NULL != cpcsDec && _DSOffsetLo == cpcsDec->nState ) ? ( MROkay ) : ( MRFail ) ;
+}
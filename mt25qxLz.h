@@ -0,0 +1,82 @@
+#ifndef __EBI_MT25Qx_LZ_H
+#define __EBI_MT25Qx_LZ_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include "mt25qx.h"
+
+#define __EBI_MT25Qx_LZ_HASH_SIZE 4096U
+#define __EBI_MT25Qx_LZ_MAX_OFFSET 65535U
+
+typedef struct {
+    unsigned char * pnOut;
+    size_t zOutCap;
+    size_t zOutLen;
+    unsigned int nState;
+    size_t zLitLen;
+    size_t zMatchLen;
+    unsigned int nOffset;
+} mt25qxLzDec_s;
+
+/**
+ * @brief compress one block into the LZ4 block format
+ * @param cpcnSrc data to be compressed
+ * @param czSrcLen length of cpcnSrc, up to __EBI_MT25Qx_LZ_MAX_OFFSET
+ * @param cpnDst buffer to store the compressed data
+ * @param czDstCap length of cpnDst
+ * @param cpnHashTab work area of __EBI_MT25Qx_LZ_HASH_SIZE entries
+ * @return length of the compressed data, 0 if it does not fit into czDstCap
+ */
+size_t
+mt25qxLzCompress(
+    const unsigned char * const cpcnSrc,
+    const size_t czSrcLen,
+    unsigned char * const cpnDst,
+    const size_t czDstCap,
+    unsigned short * const cpnHashTab
+);
+
+/**
+ * @brief start decompressing one block
+ * @param cpsDec pointer to the decoder
+ * @param cpnOut buffer to store the decompressed data
+ * @param czOutCap length of cpnOut
+ */
+void
+mt25qxLzDecInit(
+    mt25qxLzDec_s * const cpsDec,
+    unsigned char * const cpnOut,
+    const size_t czOutCap
+);
+
+/**
+ * @brief feed the next piece of compressed data, pieces can be cut anywhere
+ * @param cpsDec pointer to the decoder
+ * @param cpcnIn compressed data
+ * @param czInLen length of cpcnIn
+ * @return MROkay, MRFail if the data is corrupted or overflows cpnOut
+ */
+mt25qxRet_e
+mt25qxLzDecFeed(
+    mt25qxLzDec_s * const cpsDec,
+    const unsigned char * const cpcnIn,
+    const size_t czInLen
+);
+
+/**
+ * @brief check that the whole block has been fed
+ * @param cpcsDec pointer to the decoder
+ * @return MROkay, MRFail if the block stops in the middle of a sequence
+ */
+mt25qxRet_e
+mt25qxLzDecEnd(
+    const mt25qxLzDec_s * const cpcsDec
+);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __EBI_MT25Qx_LZ_H */
@@ -0,0 +1,990 @@
+#include "mt25qxPatch.h"
+#include "mt25qxCrc.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define _UNIT __EBI_MT25Qx_PATCH_UNIT_SIZE
+#define _ERASE_TIMEOUT_MS 400
+#define _PROGRAM_TIMEOUT_MS 10
+#define _ROUND_UP(nVal, nAlign) ( ( ( (nVal) + (nAlign) - 1 ) / (nAlign) ) * (nAlign) )
+
+/* scratch region: journal, staging, then the stash slots */
+#define _SCRATCH_JOURNAL 0U
+#define _SCRATCH_STAGING 1U
+#define _SCRATCH_STASH 2U
+#define _MAX_STASH_SLOTS 255U
+
+/* journal: header, steps (u32 each), then 2 progress bytes per step starting on a page boundary */
+#define _JOURNAL_MAGIC "M25J"
+#define _JOURNAL_VERSION 1U
+#define _JOURNAL_HEADER_SIZE 32U
+#define _PROGRESS_OFFSET(nSteps) _ROUND_UP(_JOURNAL_HEADER_SIZE + 4U * (nSteps), __EBI_MT25Qx_PAGE_SIZE)
+#define _PROGRESS_STAGED 0U
+#define _PROGRESS_DONE 1U
+#define _PROGRESS_MARK 0x00
+#define _IS_MARKED(nByte) ( 0xFF != (nByte) ) // ? a mark cut off by a power loss still counts: it is programmed after what it marks
+
+/* step: kind << 24 | stash slot << 16 | image subsector */
+#define _STEP_STASH 0x01U
+#define _STEP_WRITE 0x02U
+#define _STEP(nKind, nSlot, nUnit) ( ( (nKind) << 24 ) | ( (nSlot) << 16 ) | (nUnit) )
+#define _STEP_KIND(nStep) ( (nStep) >> 24 )
+#define _STEP_SLOT(nStep) ( ( (nStep) >> 16 ) & 0xFFU )
+#define _STEP_UNIT(nStep) ( (nStep) & 0xFFFFU )
+
+typedef struct {
+    unsigned int nKind; // ? mt25qxPatchOp_e
+    unsigned int nDstOff;
+    unsigned int nSrcOff;
+    unsigned int nLen;
+    const unsigned char * pcnData; // ? MPOInsert, MPOAdd
+} _op_s;
+
+typedef struct {
+    mt25qx_s * psFlash;
+    mt25qxPatchCfg_s sCfg;
+    mt25qxPatchStat_s sStat;
+    unsigned int nOldLen;
+    unsigned int nOldCrc;
+    unsigned int nNewLen;
+    unsigned int nNewCrc;
+    unsigned int nPatchLen;
+    unsigned int nPatchCrc;
+    _op_s * psOps; // ? sorted by nDstOff
+    unsigned int nOps;
+    unsigned int nUnits; // ? image region subsectors
+    unsigned int nMaxSteps; // ? what fits into the journal subsector
+    unsigned short * pnStash; // ? per image subsector: stash slot + 1, 0 if the old content is still in place
+    unsigned int * pnSteps;
+    unsigned int nSteps;
+    unsigned char * pnProgress; // ? 2 bytes per step as read from the journal
+    unsigned char anNew[_UNIT];
+    unsigned char anCur[_UNIT];
+    unsigned char anPage[__EBI_MT25Qx_PAGE_SIZE];
+} _patch_s;
+
+static
+void
+_putLe32(
+    unsigned char * const cpnBuf,
+    const unsigned int cnVal
+) {
+    cpnBuf[0] = (unsigned char)( cnVal >> 0 );
+    cpnBuf[1] = (unsigned char)( cnVal >> 8 );
+    cpnBuf[2] = (unsigned char)( cnVal >> 16 );
+    cpnBuf[3] = (unsigned char)( cnVal >> 24 );
+}
+
+static
+unsigned int
+_getLe32(
+    const unsigned char * const cpcnBuf
+) {
+    return
+        ( (unsigned int)cpcnBuf[0] << 0 ) | ( (unsigned int)cpcnBuf[1] << 8 ) |
+        ( (unsigned int)cpcnBuf[2] << 16 ) | ( (unsigned int)cpcnBuf[3] << 24 );
+}
+
+static
+unsigned int
+_scratchAddr(
+    const _patch_s * const cpcsThis,
+    const unsigned int cnUnit
+) {
+    return cpcsThis->sCfg.nScratchAddr + cnUnit * _UNIT;
+}
+
+/**
+ * @brief mt25qxFastRead() wants page aligned addresses: bounce the unaligned head and tail
+ */
+static
+mt25qxRet_e
+_read(
+    _patch_s * const cpsThis,
+    unsigned int nAddr,
+    unsigned char * pnBuf,
+    size_t zLen
+) {
+    size_t zSkip = 0;
+    size_t zChunk = 0;
+
+    while ( 0 < zLen )
+    {
+        zSkip = nAddr & ( __EBI_MT25Qx_PAGE_SIZE - 1 );
+        if ( 0 == zSkip && __EBI_MT25Qx_PAGE_SIZE <= zLen )
+        {
+            zChunk = zLen & ~(size_t)( __EBI_MT25Qx_PAGE_SIZE - 1 );
+            if ( MROkay != mt25qxFastRead(cpsThis->psFlash, nAddr, pnBuf, zChunk) )
+            {
+                return MRFail;
+            }
+        }
+        else
+        {
+            zChunk = __EBI_MT25Qx_PAGE_SIZE - zSkip;
+            zChunk = ( zLen > zChunk ) ? ( zChunk ) : ( zLen );
+            if ( MROkay != mt25qxFastRead(cpsThis->psFlash, nAddr - (unsigned int)zSkip, cpsThis->anPage, __EBI_MT25Qx_PAGE_SIZE) )
+            {
+                return MRFail;
+            }
+
+            memcpy(pnBuf, &cpsThis->anPage[zSkip], zChunk);
+        }
+
+        nAddr += (unsigned int)zChunk;
+        pnBuf += zChunk;
+        zLen -= zChunk;
+    }
+
+    return MROkay;
+}
+
+/**
+ * @brief read the old image, from the stash slot for the subsectors already moved there
+ */
+static
+mt25qxRet_e
+_readOld(
+    _patch_s * const cpsThis,
+    unsigned int nOffset,
+    unsigned char * pnBuf,
+    size_t zLen
+) {
+    unsigned int nUnit = 0;
+    size_t zChunk = 0;
+
+    while ( 0 < zLen )
+    {
+        nUnit = nOffset / _UNIT;
+        zChunk = _UNIT - ( nOffset % _UNIT );
+        zChunk = ( zLen > zChunk ) ? ( zChunk ) : ( zLen );
+
+        if (
+            MROkay != _read(
+                cpsThis,
+                ( 0 == cpsThis->pnStash[nUnit] ) ?
+                    ( cpsThis->sCfg.nImageAddr + nOffset ) :
+                    ( _scratchAddr(cpsThis, _SCRATCH_STASH + cpsThis->pnStash[nUnit] - 1) + nOffset % _UNIT ),
+                pnBuf,
+                zChunk
+            )
+        ) {
+            return MRFail;
+        }
+
+        nOffset += (unsigned int)zChunk;
+        pnBuf += zChunk;
+        zLen -= zChunk;
+    }
+
+    return MROkay;
+}
+
+static
+mt25qxRet_e
+_erase(
+    _patch_s * const cpsThis,
+    const unsigned int cnAddr
+) {
+    if (
+        MROkay != mt25qxTxPureCfgCmd(cpsThis->psFlash, MPCCCWriteEnable) ||
+        MROkay != mt25qxEraseStart(cpsThis->psFlash, cnAddr, MES4KB) ||
+        MRIdle != mt25qxWaitIdle(cpsThis->psFlash, _ERASE_TIMEOUT_MS)
+    ) {
+        return MRFail;
+    }
+
+    return MROkay;
+}
+
+static
+mt25qxRet_e
+_program(
+    _patch_s * const cpsThis,
+    const unsigned int cnAddr,
+    const unsigned char * const cpcnDataBuf,
+    const size_t czDataLen
+) {
+    if (
+        MROkay != mt25qxTxPureCfgCmd(cpsThis->psFlash, MPCCCWriteEnable) ||
+        MROkay != mt25qxPageProgramStart(cpsThis->psFlash, cnAddr, cpcnDataBuf, czDataLen) ||
+        MRIdle != mt25qxWaitIdle(cpsThis->psFlash, _PROGRAM_TIMEOUT_MS)
+    ) {
+        return MRFail;
+    }
+
+    return MROkay;
+}
+
+/**
+ * @brief erase a subsector and program it with cpcnDataBuf, skipping the pages left all 0xFF
+ */
+static
+mt25qxRet_e
+_rewriteUnit(
+    _patch_s * const cpsThis,
+    const unsigned int cnAddr,
+    const unsigned char * const cpcnDataBuf
+) {
+    unsigned int nOffset = 0;
+    unsigned int nIdx = 0;
+
+    if ( MROkay != _erase(cpsThis, cnAddr) )
+    {
+        return MRFail;
+    }
+
+    for ( nOffset = 0; _UNIT > nOffset; nOffset += __EBI_MT25Qx_PAGE_SIZE )
+    {
+        for ( nIdx = 0; __EBI_MT25Qx_PAGE_SIZE > nIdx && 0xFF == cpcnDataBuf[nOffset + nIdx]; ++nIdx ) {}
+
+        if ( __EBI_MT25Qx_PAGE_SIZE != nIdx && MROkay != _program(cpsThis, cnAddr + nOffset, &cpcnDataBuf[nOffset], __EBI_MT25Qx_PAGE_SIZE) )
+        {
+            return MRFail;
+        }
+    }
+
+    return MROkay;
+}
+
+static
+mt25qxRet_e
+_regionCrc(
+    _patch_s * const cpsThis,
+    const unsigned int cnAddr,
+    const unsigned int cnLen,
+    unsigned int * const cpnCrc
+) {
+    unsigned int nOffset = 0;
+    unsigned int nChunk = 0;
+
+    *cpnCrc = 0;
+    for ( nOffset = 0; cnLen > nOffset; nOffset += nChunk )
+    {
+        nChunk = ( cnLen - nOffset > _UNIT ) ? ( _UNIT ) : ( cnLen - nOffset );
+        if ( MROkay != _read(cpsThis, cnAddr + nOffset, cpsThis->anCur, nChunk) )
+        {
+            return MRFail;
+        }
+
+        *cpnCrc = mt25qxCrc32c(*cpnCrc, cpsThis->anCur, nChunk);
+    }
+
+    return MROkay;
+}
+
+/**
+ * @brief validate the patch and index its ops, two passes: count, then fill
+ */
+static
+mt25qxRet_e
+_parse(
+    _patch_s * const cpsThis,
+    const unsigned char * const cpcnPatch,
+    const size_t czPatchLen
+) {
+    unsigned int nPass = 0;
+    size_t zPos = 0;
+    unsigned int nDstOff = 0;
+    unsigned int nCount = 0;
+    _op_s sOp;
+
+    if ( __EBI_MT25Qx_PATCH_HEADER_SIZE > czPatchLen || 0 != memcmp(cpcnPatch, __EBI_MT25Qx_PATCH_MAGIC, 4) )
+    {
+        return MRFail;
+    }
+
+    cpsThis->nOldLen = _getLe32(&cpcnPatch[4]);
+    cpsThis->nOldCrc = _getLe32(&cpcnPatch[8]);
+    cpsThis->nNewLen = _getLe32(&cpcnPatch[12]);
+    cpsThis->nNewCrc = _getLe32(&cpcnPatch[16]);
+    cpsThis->nPatchLen = (unsigned int)czPatchLen;
+    cpsThis->nPatchCrc = mt25qxCrc32c(0, cpcnPatch, czPatchLen);
+
+    if ( cpsThis->sCfg.nImageCap < cpsThis->nOldLen || cpsThis->sCfg.nImageCap < cpsThis->nNewLen )
+    {
+        return MRFail;
+    }
+
+    for ( nPass = 0; 2 > nPass; ++nPass )
+    {
+        zPos = __EBI_MT25Qx_PATCH_HEADER_SIZE;
+        nDstOff = 0;
+        nCount = 0;
+
+        while ( czPatchLen > zPos )
+        {
+            memset(&sOp, 0, sizeof(sOp));
+            sOp.nKind = cpcnPatch[zPos++];
+            sOp.nDstOff = nDstOff;
+
+            switch ( sOp.nKind )
+            {
+            case MPOCopy:
+            case MPOAdd:
+                if ( 8 > czPatchLen - zPos )
+                {
+                    return MRFail;
+                }
+
+                sOp.nSrcOff = _getLe32(&cpcnPatch[zPos]);
+                sOp.nLen = _getLe32(&cpcnPatch[zPos + 4]);
+                zPos += 8;
+
+                if ( cpsThis->nOldLen < sOp.nSrcOff || cpsThis->nOldLen - sOp.nSrcOff < sOp.nLen )
+                {
+                    return MRFail;
+                }
+                break;
+
+            case MPOInsert:
+                if ( 4 > czPatchLen - zPos )
+                {
+                    return MRFail;
+                }
+
+                sOp.nLen = _getLe32(&cpcnPatch[zPos]);
+                zPos += 4;
+                break;
+
+            default:
+                return MRFail;
+            }
+
+            if ( MPOCopy != sOp.nKind )
+            {
+                if ( sOp.nLen > czPatchLen - zPos )
+                {
+                    return MRFail;
+                }
+
+                sOp.pcnData = &cpcnPatch[zPos];
+                zPos += sOp.nLen;
+            }
+
+            if ( cpsThis->nNewLen - nDstOff < sOp.nLen )
+            {
+                return MRFail;
+            }
+
+            nDstOff += sOp.nLen;
+            if ( 0 == sOp.nLen )
+            {
+                continue;
+            }
+
+            if ( 1 == nPass )
+            {
+                memcpy(&cpsThis->psOps[nCount], &sOp, sizeof(_op_s));
+            }
+
+            ++nCount;
+        }
+
+        if ( cpsThis->nNewLen != nDstOff )
+        {
+            return MRFail;
+        }
+
+        if ( 0 == nPass )
+        {
+            cpsThis->psOps = (_op_s *)calloc(( 0 == nCount ) ? ( 1 ) : ( nCount ), sizeof(_op_s));
+            if ( NULL == cpsThis->psOps )
+            {
+                return MRFail;
+            }
+        }
+    }
+
+    cpsThis->nOps = nCount;
+    return MROkay;
+}
+
+/**
+ * @brief first op producing bytes at or after cnOffset of the new image
+ */
+static
+unsigned int
+_findOp(
+    const _patch_s * const cpcsThis,
+    const unsigned int cnOffset
+) {
+    unsigned int nLow = 0;
+    unsigned int nHigh = cpcsThis->nOps;
+    unsigned int nMid = 0;
+
+    while ( nLow < nHigh )
+    {
+        nMid = nLow + ( nHigh - nLow ) / 2;
+        if ( cpcsThis->psOps[nMid].nDstOff + cpcsThis->psOps[nMid].nLen <= cnOffset )
+        {
+            nLow = nMid + 1;
+        }
+        else
+        {
+            nHigh = nMid;
+        }
+    }
+
+    return nLow;
+}
+
+/**
+ * @brief produce the new content of image subsector cnUnit into anNew, 0xFF past the new image
+ */
+static
+mt25qxRet_e
+_buildUnit(
+    _patch_s * const cpsThis,
+    const unsigned int cnUnit
+) {
+    const unsigned int cnStart = cnUnit * _UNIT;
+    const unsigned int cnEnd = ( cpsThis->nNewLen - cnStart > _UNIT ) ? ( cnStart + _UNIT ) : ( cpsThis->nNewLen );
+    const _op_s * pcsOp = NULL;
+    unsigned int nOp = 0;
+    unsigned int nLow = 0;
+    unsigned int nHigh = 0;
+    unsigned int nIdx = 0;
+
+    memset(cpsThis->anNew, 0xFF, _UNIT);
+
+    for ( nOp = _findOp(cpsThis, cnStart); cpsThis->nOps > nOp && cnEnd > cpsThis->psOps[nOp].nDstOff; ++nOp )
+    {
+        pcsOp = &cpsThis->psOps[nOp];
+        nLow = ( pcsOp->nDstOff > cnStart ) ? ( pcsOp->nDstOff ) : ( cnStart );
+        nHigh = ( pcsOp->nDstOff + pcsOp->nLen < cnEnd ) ? ( pcsOp->nDstOff + pcsOp->nLen ) : ( cnEnd );
+
+        if ( MPOInsert == pcsOp->nKind )
+        {
+            memcpy(&cpsThis->anNew[nLow - cnStart], &pcsOp->pcnData[nLow - pcsOp->nDstOff], nHigh - nLow);
+            continue;
+        }
+
+        if ( MROkay != _readOld(cpsThis, pcsOp->nSrcOff + ( nLow - pcsOp->nDstOff ), &cpsThis->anNew[nLow - cnStart], nHigh - nLow) )
+        {
+            return MRFail;
+        }
+
+        if ( MPOAdd == pcsOp->nKind )
+        {
+            for ( nIdx = nLow; nHigh > nIdx; ++nIdx )
+            {
+                cpsThis->anNew[nIdx - cnStart] += pcsOp->pcnData[nIdx - pcsOp->nDstOff];
+            }
+        }
+    }
+
+    return MROkay;
+}
+
+/**
+ * @brief old image subsectors read to build new subsector cnUnit, stored to cpnOut if not NULL
+ * @return amount of entries, a range spanning several subsectors gives one entry each; the same
+ *         with or without cpnOut, the edge table is sized from the counting pass
+ */
+static
+unsigned int
+_sources(
+    const _patch_s * const cpcsThis,
+    const unsigned int cnUnit,
+    unsigned int * const cpnOut
+) {
+    const unsigned int cnStart = cnUnit * _UNIT;
+    const unsigned int cnEnd = ( cpcsThis->nNewLen - cnStart > _UNIT ) ? ( cnStart + _UNIT ) : ( cpcsThis->nNewLen );
+    const _op_s * pcsOp = NULL;
+    unsigned int nOp = 0;
+    unsigned int nLow = 0;
+    unsigned int nHigh = 0;
+    unsigned int nSrc = 0;
+    unsigned int nPrev = 0;
+    unsigned int nCount = 0;
+
+    for ( nOp = _findOp(cpcsThis, cnStart); cpcsThis->nOps > nOp && cnEnd > cpcsThis->psOps[nOp].nDstOff; ++nOp )
+    {
+        pcsOp = &cpcsThis->psOps[nOp];
+        if ( MPOInsert == pcsOp->nKind )
+        {
+            continue;
+        }
+
+        nLow = ( pcsOp->nDstOff > cnStart ) ? ( pcsOp->nDstOff ) : ( cnStart );
+        nHigh = ( pcsOp->nDstOff + pcsOp->nLen < cnEnd ) ? ( pcsOp->nDstOff + pcsOp->nLen ) : ( cnEnd );
+        nLow = pcsOp->nSrcOff + ( nLow - pcsOp->nDstOff );
+        nHigh = pcsOp->nSrcOff + ( nHigh - pcsOp->nDstOff );
+
+        for ( nSrc = nLow / _UNIT; ( nHigh - 1 ) / _UNIT >= nSrc; ++nSrc )
+        {
+            /* consecutive ops mostly read the same subsector: drop the repeats, in both passes */
+            if ( 0 < nCount && nSrc == nPrev )
+            {
+                continue;
+            }
+
+            if ( NULL != cpnOut )
+            {
+                cpnOut[nCount] = nSrc;
+            }
+
+            nPrev = nSrc;
+            ++nCount;
+        }
+    }
+
+    return nCount;
+}
+
+/**
+ * @brief find the changed subsectors and order them so that no subsector is overwritten while
+ *        another one still has to read its old content
+ * @details
+ * - reader -> source edges between changed subsectors, Kahn's algorithm on them
+ * - when every pending subsector is still read by another one, there is a cycle: the pending
+ *   one with the most readers gets its old content stashed, its readers take it from the stash slot
+ */
+static
+mt25qxRet_e
+_plan(
+    _patch_s * const cpsThis
+) {
+    const unsigned int cnNewUnits = _ROUND_UP(cpsThis->nNewLen, _UNIT) / _UNIT;
+    const unsigned int cnMaxSlots =
+        ( _MAX_STASH_SLOTS < cpsThis->sCfg.nScratchUnits - _SCRATCH_STASH ) ?
+            ( _MAX_STASH_SLOTS ) : ( cpsThis->sCfg.nScratchUnits - _SCRATCH_STASH );
+    mt25qxRet_e eRet = MRFail;
+    unsigned char * pnState = NULL; // ? 0 unchanged, 1 pending, 2 written
+    unsigned int * pnInDeg = NULL;
+    unsigned int * pnEdgeIdx = NULL;
+    unsigned int * pnEdges = NULL;
+    unsigned int nPending = 0;
+    unsigned int nSlots = 0;
+    unsigned int nUnit = 0;
+    unsigned int nEdge = 0;
+    unsigned int nSrc = 0;
+
+    pnState = (unsigned char *)calloc(cnNewUnits + 1, sizeof(unsigned char));
+    pnInDeg = (unsigned int *)calloc(cnNewUnits + 1, sizeof(unsigned int));
+    pnEdgeIdx = (unsigned int *)calloc(cnNewUnits + 1, sizeof(unsigned int));
+    cpsThis->pnSteps = (unsigned int *)calloc(cpsThis->nMaxSteps, sizeof(unsigned int));
+    if ( NULL == pnState || NULL == pnInDeg || NULL == pnEdgeIdx || NULL == cpsThis->pnSteps )
+    {
+        goto __exit;
+    }
+
+    for ( nUnit = 0; cnNewUnits > nUnit; ++nUnit )
+    {
+        if (
+            MROkay != _buildUnit(cpsThis, nUnit) ||
+            MROkay != _read(cpsThis, cpsThis->sCfg.nImageAddr + nUnit * _UNIT, cpsThis->anCur, _UNIT)
+        ) {
+            goto __exit;
+        }
+
+        if ( 0 == memcmp(cpsThis->anNew, cpsThis->anCur, _UNIT) )
+        {
+            ++cpsThis->sStat.nUnchanged;
+            continue;
+        }
+
+        pnState[nUnit] = 1;
+        pnEdgeIdx[nUnit + 1] = _sources(cpsThis, nUnit, NULL);
+        ++nPending;
+    }
+
+    for ( nUnit = 0; cnNewUnits > nUnit; ++nUnit )
+    {
+        pnEdgeIdx[nUnit + 1] += pnEdgeIdx[nUnit];
+    }
+
+    pnEdges = (unsigned int *)calloc(pnEdgeIdx[cnNewUnits] + 1, sizeof(unsigned int));
+    if ( NULL == pnEdges )
+    {
+        goto __exit;
+    }
+
+    /* only a changed source read by another changed subsector has to wait */
+    for ( nUnit = 0; cnNewUnits > nUnit; ++nUnit )
+    {
+        if ( 1 != pnState[nUnit] )
+        {
+            continue;
+        }
+
+        _sources(cpsThis, nUnit, &pnEdges[pnEdgeIdx[nUnit]]);
+        for ( nEdge = pnEdgeIdx[nUnit]; pnEdgeIdx[nUnit + 1] > nEdge; ++nEdge )
+        {
+            nSrc = pnEdges[nEdge];
+            if ( nSrc != nUnit && cnNewUnits > nSrc && 1 == pnState[nSrc] )
+            {
+                ++pnInDeg[nSrc];
+            }
+        }
+    }
+
+    while ( 0 < nPending )
+    {
+        for ( nUnit = 0; cnNewUnits > nUnit && !( 1 == pnState[nUnit] && 0 == pnInDeg[nUnit] ); ++nUnit ) {}
+
+        if ( cnNewUnits == nUnit )
+        {
+            for ( nUnit = 0, nSrc = 0; cnNewUnits > nSrc; ++nSrc )
+            {
+                if ( 1 == pnState[nSrc] && ( 1 != pnState[nUnit] || pnInDeg[nSrc] > pnInDeg[nUnit] ) )
+                {
+                    nUnit = nSrc;
+                }
+            }
+
+            if ( cnMaxSlots <= nSlots || cpsThis->nMaxSteps <= cpsThis->nSteps )
+            {
+                goto __exit;
+            }
+
+            cpsThis->pnSteps[cpsThis->nSteps++] = _STEP(_STEP_STASH, nSlots, nUnit);
+            ++nSlots;
+            pnInDeg[nUnit] = 0;
+        }
+
+        if ( cpsThis->nMaxSteps <= cpsThis->nSteps )
+        {
+            goto __exit;
+        }
+
+        cpsThis->pnSteps[cpsThis->nSteps++] = _STEP(_STEP_WRITE, 0, nUnit);
+        pnState[nUnit] = 2;
+        --nPending;
+
+        for ( nEdge = pnEdgeIdx[nUnit]; pnEdgeIdx[nUnit + 1] > nEdge; ++nEdge )
+        {
+            nSrc = pnEdges[nEdge];
+            if ( nSrc != nUnit && cnNewUnits > nSrc && 1 == pnState[nSrc] && 0 < pnInDeg[nSrc] )
+            {
+                --pnInDeg[nSrc];
+            }
+        }
+    }
+
+    eRet = MROkay;
+
+__exit:
+    free(pnEdges);
+    free(pnEdgeIdx);
+    free(pnInDeg);
+    free(pnState);
+    return eRet;
+}
+
+/**
+ * @brief program the plan into the erased journal subsector, the page holding the magic last
+ */
+static
+mt25qxRet_e
+_journalWrite(
+    _patch_s * const cpsThis
+) {
+    const unsigned int cnAddr = _scratchAddr(cpsThis, _SCRATCH_JOURNAL);
+    const unsigned int cnLen = _JOURNAL_HEADER_SIZE + 4U * cpsThis->nSteps;
+    unsigned int nIdx = 0;
+    unsigned int nOffset = 0;
+
+    memset(cpsThis->anNew, 0xFF, _UNIT);
+    memcpy(&cpsThis->anNew[0], _JOURNAL_MAGIC, 4);
+    _putLe32(&cpsThis->anNew[4], _JOURNAL_VERSION);
+    _putLe32(&cpsThis->anNew[8], cpsThis->nPatchLen);
+    _putLe32(&cpsThis->anNew[12], cpsThis->nPatchCrc);
+    _putLe32(&cpsThis->anNew[16], cpsThis->nSteps);
+
+    for ( nIdx = 0; cpsThis->nSteps > nIdx; ++nIdx )
+    {
+        _putLe32(&cpsThis->anNew[_JOURNAL_HEADER_SIZE + 4U * nIdx], cpsThis->pnSteps[nIdx]);
+    }
+
+    if ( MROkay != _erase(cpsThis, cnAddr) )
+    {
+        return MRFail;
+    }
+
+    for ( nOffset = _ROUND_UP(cnLen, __EBI_MT25Qx_PAGE_SIZE); 0 < nOffset; )
+    {
+        nOffset -= __EBI_MT25Qx_PAGE_SIZE;
+        if ( MROkay != _program(cpsThis, cnAddr + nOffset, &cpsThis->anNew[nOffset], __EBI_MT25Qx_PAGE_SIZE) )
+        {
+            return MRFail;
+        }
+    }
+
+    return MROkay;
+}
+
+/**
+ * @brief load an interrupted plan
+ * @return MROkay with nSteps set, MRIdle if there is no journal, MRFail if it belongs to another patch
+ */
+static
+mt25qxRet_e
+_journalRead(
+    _patch_s * const cpsThis
+) {
+    const unsigned int cnAddr = _scratchAddr(cpsThis, _SCRATCH_JOURNAL);
+    unsigned char anHeader[_JOURNAL_HEADER_SIZE] = {0};
+    unsigned int nIdx = 0;
+
+    if ( MROkay != _read(cpsThis, cnAddr, anHeader, sizeof(anHeader)) )
+    {
+        return MRFail;
+    }
+
+    if ( 0 != memcmp(anHeader, _JOURNAL_MAGIC, 4) )
+    {
+        return MRIdle;
+    }
+
+    if (
+        _JOURNAL_VERSION != _getLe32(&anHeader[4]) ||
+        cpsThis->nPatchLen != _getLe32(&anHeader[8]) ||
+        cpsThis->nPatchCrc != _getLe32(&anHeader[12]) ||
+        cpsThis->nMaxSteps < _getLe32(&anHeader[16])
+    ) {
+        return MRFail;
+    }
+
+    cpsThis->nSteps = _getLe32(&anHeader[16]);
+    cpsThis->pnSteps = (unsigned int *)calloc(cpsThis->nSteps + 1, sizeof(unsigned int));
+    if (
+        NULL == cpsThis->pnSteps ||
+        MROkay != _read(cpsThis, cnAddr, cpsThis->anNew, _JOURNAL_HEADER_SIZE + 4U * cpsThis->nSteps)
+    ) {
+        return MRFail;
+    }
+
+    for ( nIdx = 0; cpsThis->nSteps > nIdx; ++nIdx )
+    {
+        cpsThis->pnSteps[nIdx] = _getLe32(&cpsThis->anNew[_JOURNAL_HEADER_SIZE + 4U * nIdx]);
+        if (
+            cpsThis->nUnits <= _STEP_UNIT(cpsThis->pnSteps[nIdx]) ||
+            ( _STEP_STASH != _STEP_KIND(cpsThis->pnSteps[nIdx]) && _STEP_WRITE != _STEP_KIND(cpsThis->pnSteps[nIdx]) ) ||
+            ( _STEP_STASH == _STEP_KIND(cpsThis->pnSteps[nIdx]) && cpsThis->sCfg.nScratchUnits - _SCRATCH_STASH <= _STEP_SLOT(cpsThis->pnSteps[nIdx]) )
+        ) {
+            return MRFail;
+        }
+    }
+
+    return MROkay;
+}
+
+static
+mt25qxRet_e
+_mark(
+    _patch_s * const cpsThis,
+    const unsigned int cnStep,
+    const unsigned int cnWhich
+) {
+    const unsigned char cnMark = _PROGRESS_MARK;
+
+    return _program(
+        cpsThis,
+        _scratchAddr(cpsThis, _SCRATCH_JOURNAL) + _PROGRESS_OFFSET(cpsThis->nSteps) + 2U * cnStep + cnWhich,
+        &cnMark,
+        1
+    );
+}
+
+/**
+ * @brief run the plan from the first step not marked done
+ * @details
+ * - stash: copy the old subsector to its slot, mark done
+ * - write: build the new content, put it to staging, mark staged, rewrite the image subsector,
+ *   mark done; a step found staged but not done is finished from staging, its sources may be gone
+ */
+static
+mt25qxRet_e
+_execute(
+    _patch_s * const cpsThis
+) {
+    unsigned int nIdx = 0;
+    unsigned int nStep = 0;
+    unsigned int nUnit = 0;
+    unsigned int nSlotAddr = 0;
+
+    cpsThis->pnProgress = (unsigned char *)malloc(2U * cpsThis->nSteps + 1);
+    if (
+        NULL == cpsThis->pnProgress ||
+        MROkay != _read(
+            cpsThis,
+            _scratchAddr(cpsThis, _SCRATCH_JOURNAL) + _PROGRESS_OFFSET(cpsThis->nSteps),
+            cpsThis->pnProgress,
+            2U * cpsThis->nSteps
+        )
+    ) {
+        return MRFail;
+    }
+
+    memset(cpsThis->pnStash, 0, cpsThis->nUnits * sizeof(unsigned short));
+
+    for ( nIdx = 0; cpsThis->nSteps > nIdx; ++nIdx )
+    {
+        nStep = cpsThis->pnSteps[nIdx];
+        nUnit = _STEP_UNIT(nStep);
+
+        if ( _STEP_STASH == _STEP_KIND(nStep) )
+        {
+            nSlotAddr = _scratchAddr(cpsThis, _SCRATCH_STASH + _STEP_SLOT(nStep));
+            if (
+                !_IS_MARKED(cpsThis->pnProgress[2U * nIdx + _PROGRESS_DONE]) && (
+                    MROkay != _read(cpsThis, cpsThis->sCfg.nImageAddr + nUnit * _UNIT, cpsThis->anCur, _UNIT) ||
+                    MROkay != _rewriteUnit(cpsThis, nSlotAddr, cpsThis->anCur) ||
+                    MROkay != _mark(cpsThis, nIdx, _PROGRESS_DONE)
+                )
+            ) {
+                return MRFail;
+            }
+
+            cpsThis->pnStash[nUnit] = (unsigned short)( _STEP_SLOT(nStep) + 1 );
+            ++cpsThis->sStat.nStashed;
+            continue;
+        }
+
+        if ( _IS_MARKED(cpsThis->pnProgress[2U * nIdx + _PROGRESS_DONE]) )
+        {
+            ++cpsThis->sStat.nRewritten;
+            continue;
+        }
+
+        if ( _IS_MARKED(cpsThis->pnProgress[2U * nIdx + _PROGRESS_STAGED]) )
+        {
+            if ( MROkay != _read(cpsThis, _scratchAddr(cpsThis, _SCRATCH_STAGING), cpsThis->anNew, _UNIT) )
+            {
+                return MRFail;
+            }
+        }
+        else if (
+            MROkay != _buildUnit(cpsThis, nUnit) ||
+            MROkay != _rewriteUnit(cpsThis, _scratchAddr(cpsThis, _SCRATCH_STAGING), cpsThis->anNew) ||
+            MROkay != _mark(cpsThis, nIdx, _PROGRESS_STAGED)
+        ) {
+            return MRFail;
+        }
+
+        if (
+            MROkay != _rewriteUnit(cpsThis, cpsThis->sCfg.nImageAddr + nUnit * _UNIT, cpsThis->anNew) ||
+            MROkay != _mark(cpsThis, nIdx, _PROGRESS_DONE)
+        ) {
+            return MRFail;
+        }
+
+        ++cpsThis->sStat.nRewritten;
+    }
+
+    return MROkay;
+}
+
+mt25qxRet_e
+mt25qxPatchApply(
+    mt25qx_s * const cpsFlash,
+    const mt25qxPatchCfg_s * const cpcsCfg,
+    const unsigned char * const cpcnPatch,
+    const size_t czPatchLen,
+    mt25qxPatchStat_s * const cpsStat
+) {
+    mt25qxRet_e eRet = MRFail;
+    _patch_s * psThis = NULL;
+    unsigned int nCrc = 0;
+
+    if (
+        NULL == cpsFlash || NULL == cpcsCfg || NULL == cpcnPatch ||
+        0 != ( cpcsCfg->nImageAddr & ( _UNIT - 1 ) ) ||
+        0 != ( cpcsCfg->nImageCap & ( _UNIT - 1 ) ) ||
+        0 != ( cpcsCfg->nScratchAddr & ( _UNIT - 1 ) ) ||
+        0 == cpcsCfg->nImageCap || 0xFFFFU * _UNIT < cpcsCfg->nImageCap ||
+        _SCRATCH_STASH > cpcsCfg->nScratchUnits ||
+        !(
+            cpcsCfg->nScratchAddr + cpcsCfg->nScratchUnits * _UNIT <= cpcsCfg->nImageAddr ||
+            cpcsCfg->nImageAddr + cpcsCfg->nImageCap <= cpcsCfg->nScratchAddr
+        )
+    ) {
+        return MRFail;
+    }
+
+    psThis = (_patch_s *)calloc(1, sizeof(_patch_s));
+    if ( NULL == psThis )
+    {
+        return MRFail;
+    }
+
+    psThis->psFlash = cpsFlash;
+    memcpy(&psThis->sCfg, cpcsCfg, sizeof(mt25qxPatchCfg_s));
+    psThis->nUnits = cpcsCfg->nImageCap / _UNIT;
+    psThis->nMaxSteps = ( _UNIT - __EBI_MT25Qx_PAGE_SIZE - _JOURNAL_HEADER_SIZE ) / 6U;
+    psThis->pnStash = (unsigned short *)calloc(psThis->nUnits, sizeof(unsigned short));
+
+    if ( NULL == psThis->pnStash || MROkay != _parse(psThis, cpcnPatch, czPatchLen) )
+    {
+        goto __exit;
+    }
+
+    switch ( _journalRead(psThis) )
+    {
+    case MROkay:
+        psThis->sStat.bResumed = true;
+        break;
+
+    case MRIdle:
+        /* no update in progress: the image is either the old one or already the new one */
+        if ( MROkay != _regionCrc(psThis, cpcsCfg->nImageAddr, psThis->nOldLen, &nCrc) )
+        {
+            goto __exit;
+        }
+
+        if ( psThis->nOldCrc != nCrc )
+        {
+            if (
+                MROkay == _regionCrc(psThis, cpcsCfg->nImageAddr, psThis->nNewLen, &nCrc) &&
+                psThis->nNewCrc == nCrc
+            ) {
+                eRet = MROkay;
+            }
+
+            goto __exit;
+        }
+
+        if ( MROkay != _plan(psThis) || MROkay != _journalWrite(psThis) )
+        {
+            goto __exit;
+        }
+        break;
+
+    default:
+        goto __exit;
+    }
+
+    psThis->sStat.nSteps = psThis->nSteps;
+
+    if (
+        MROkay != _execute(psThis) ||
+        MROkay != _regionCrc(psThis, cpcsCfg->nImageAddr, psThis->nNewLen, &nCrc) ||
+        psThis->nNewCrc != nCrc
+    ) {
+        goto __exit;
+    }
+
+    /* the update is complete once the magic is gone, an erase cut off could leave it readable */
+    memset(psThis->anPage, 0x00, 4);
+    if ( MROkay != _program(psThis, _scratchAddr(psThis, _SCRATCH_JOURNAL), psThis->anPage, 4) )
+    {
+        goto __exit;
+    }
+
+    eRet = _erase(psThis, _scratchAddr(psThis, _SCRATCH_JOURNAL));
+
+__exit:
+    if ( NULL != cpsStat )
+    {
+        memcpy(cpsStat, &psThis->sStat, sizeof(mt25qxPatchStat_s));
+    }
+
+    free(psThis->pnProgress);
+    free(psThis->pnSteps);
+    free(psThis->pnStash);
+    free(psThis->psOps);
+    free(psThis);
+    return eRet;
+}
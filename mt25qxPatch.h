@@ -0,0 +1,71 @@
+#ifndef __EBI_MT25Qx_PATCH_H
+#define __EBI_MT25Qx_PATCH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include "mt25qx.h"
+
+#define __EBI_MT25Qx_PATCH_MAGIC "M25P"
+#define __EBI_MT25Qx_PATCH_HEADER_SIZE 20U
+#define __EBI_MT25Qx_PATCH_UNIT_SIZE 4096U
+
+typedef enum {
+    MPOCopy = 0x01, // ? u32 old offset, u32 length: copy from the old image
+    MPOInsert = 0x02, // ? u32 length, length bytes: new data
+    MPOAdd = 0x03 // ? u32 old offset, u32 length, length bytes: old + byte-wise difference (as bsdiff)
+} mt25qxPatchOp_e;
+
+typedef struct {
+    unsigned int nImageAddr; // ? 0x00000000 + ( N * __EBI_MT25Qx_PATCH_UNIT_SIZE ), old image is here, new image goes here
+    unsigned int nImageCap; // ? size of the image region, a multiple of __EBI_MT25Qx_PATCH_UNIT_SIZE
+    unsigned int nScratchAddr; // ? 0x00000000 + ( N * __EBI_MT25Qx_PATCH_UNIT_SIZE ), outside of the image region
+    unsigned int nScratchUnits; // ? 2 or more: journal, staging, then one per subsector that has to be stashed
+} mt25qxPatchCfg_s;
+
+typedef struct {
+    unsigned int nSteps; // ? planned steps, kept in the journal
+    unsigned int nRewritten; // ? image subsectors rewritten
+    unsigned int nUnchanged; // ? image subsectors whose content is the same after patching, not touched
+    unsigned int nStashed; // ? subsectors copied to scratch to break a read-after-overwrite cycle
+    bool bResumed; // ? an interrupted patch was found in the journal and finished
+} mt25qxPatchStat_s;
+
+/**
+ * @brief apply a binary delta to the image in flash, in place and power loss safe
+ * @param cpsFlash pointer to a mt25qx_s instance
+ * @param cpcsCfg image and scratch regions
+ * @param cpcnPatch the whole patch
+ * @param czPatchLen length of cpcnPatch
+ * @param cpsStat pointer to store the statistics, can be NULL
+ * @return MROkay, MRFail
+ * @details
+ * - patch: header (__EBI_MT25Qx_PATCH_HEADER_SIZE bytes): magic "M25P", u32 old length, 
+ *   u32 old CRC32C, u32 new length, u32 new CRC32C; then mt25qxPatchOp_e ops, each one a u8 
+ *   opcode with its arguments, producing the new image from offset 0; all values little-endian
+ * - only subsectors whose content changes are erased and programmed, in an order where no
+ *   subsector is overwritten before every subsector reading its old content is written;
+ *   cycles are broken by stashing the old content in the scratch region
+ * - the plan and the progress are kept in the first scratch subsector, every subsector goes
+ *   through the second one before it is erased: call again with the same patch after a power
+ *   loss to finish the update
+ * - return MROkay without writing if the image already is the new one
+ * @warning
+ * - return MRFail if the image is neither the old nor the new one, or if the plan does not fit
+ *   into one journal subsector (about 600 changed subsectors)
+ */
+mt25qxRet_e
+mt25qxPatchApply(
+    mt25qx_s * const cpsFlash,
+    const mt25qxPatchCfg_s * const cpcsCfg,
+    const unsigned char * const cpcnPatch,
+    const size_t czPatchLen,
+    mt25qxPatchStat_s * const cpsStat
+);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __EBI_MT25Qx_PATCH_H */
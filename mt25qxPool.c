@@ -0,0 +1,351 @@
+#include "mt25qxPool.h"
+#include <stdlib.h>
+
+#define _BITS_PER_WORD ( 8 * sizeof(unsigned int) )
+#define _WORDS(nUnits) ( ( (nUnits) + _BITS_PER_WORD - 1 ) / _BITS_PER_WORD )
+#define _BIT_GET(pnMap, nIdx) ( 0 != ( (pnMap)[(nIdx) / _BITS_PER_WORD] & ( 1U << ( (nIdx) % _BITS_PER_WORD ) ) ) )
+#define _BIT_SET(pnMap, nIdx) ( (pnMap)[(nIdx) / _BITS_PER_WORD] |= ( 1U << ( (nIdx) % _BITS_PER_WORD ) ) )
+#define _BIT_CLR(pnMap, nIdx) ( (pnMap)[(nIdx) / _BITS_PER_WORD] &= ~( 1U << ( (nIdx) % _BITS_PER_WORD ) ) )
+
+struct mt25qxPool_s {
+    mt25qx_s * psFlash;
+    unsigned int nBaseAddr;
+    unsigned int nUnits;
+    unsigned int * pnErased; // ? bitmap: 1 = known erased, ready to be handed out
+    unsigned int * pnDirty; // ? bitmap: 1 = waiting in pnQueue to be erased
+    unsigned int * pnQueue; // ? FIFO of dirty unit indices, each unit appears at most once
+    unsigned int nQueueHead;
+    unsigned int nQueueLen;
+    unsigned int nErasedCount;
+    unsigned int nCursor; // ? word to start the next mt25qxPoolAcquire() scan from
+    unsigned int nInFlight; // ? unit being erased, nUnits if none
+    bool bSuspended; // ? the erase in flight was suspended by mt25qxPoolSuspend()
+    bool bWriterOwned; // ? between a successful mt25qxPoolSuspend() and mt25qxPoolResume()
+};
+
+static
+void
+_pushDirty(
+    mt25qxPool_s * const cpsThis,
+    const unsigned int cnIdx
+) {
+    _BIT_SET(cpsThis->pnDirty, cnIdx);
+    cpsThis->pnQueue[( cpsThis->nQueueHead + cpsThis->nQueueLen ) % cpsThis->nUnits] = cnIdx;
+    ++cpsThis->nQueueLen;
+}
+
+static
+mt25qxRet_e
+_finishErase(
+    mt25qxPool_s * const cpsThis
+) {
+    mt25qxReg_s sReg = {0};
+    const unsigned int cnIdx = cpsThis->nInFlight;
+
+    /* keep it in flight until the result is known, the next call tries again */
+    sReg.eReg = MRFlagStatusReg;
+    if ( MROkay != mt25qxGetReg(cpsThis->psFlash, &sReg) )
+    {
+        return MRFail;
+    }
+
+    /* failed or protected: dropped, it would fail again; a flag left set would fail the next one */
+    if ( 1 == sReg.uReg.sFlagStatusReg.nEraseRet )
+    {
+        if ( MROkay == mt25qxTxPureCfgCmd(cpsThis->psFlash, MPCCCClearFlagStatusReg) )
+        {
+            cpsThis->nInFlight = cpsThis->nUnits;
+        }
+
+        return MRFail;
+    }
+
+    cpsThis->nInFlight = cpsThis->nUnits;
+
+    _BIT_SET(cpsThis->pnErased, cnIdx);
+    ++cpsThis->nErasedCount;
+    return MROkay;
+}
+
+mt25qxPool_s *
+mt25qxPoolMake(
+    mt25qx_s * const cpsFlash,
+    const unsigned int cnBaseAddr,
+    const unsigned int cnUnits
+) {
+    unsigned int nIdx = 0;
+    mt25qxPool_s * cpsThis = NULL;
+
+    if ( 
+        NULL == cpsFlash || 0 == cnUnits ||
+        0 != ( cnBaseAddr & ( __EBI_MT25Qx_POOL_UNIT_SIZE - 1 ) )
+    ) {
+        return NULL;
+    }
+
+    cpsThis = (mt25qxPool_s *)calloc(1, sizeof(mt25qxPool_s));
+    if ( NULL == cpsThis )
+    {
+        goto __error;
+    }
+
+    cpsThis->pnErased = (unsigned int *)calloc(_WORDS(cnUnits), sizeof(unsigned int));
+    cpsThis->pnDirty = (unsigned int *)calloc(_WORDS(cnUnits), sizeof(unsigned int));
+    cpsThis->pnQueue = (unsigned int *)calloc(cnUnits, sizeof(unsigned int));
+    if ( NULL == cpsThis->pnErased || NULL == cpsThis->pnDirty || NULL == cpsThis->pnQueue )
+    {
+        goto __error;
+    }
+
+    cpsThis->psFlash = cpsFlash;
+    cpsThis->nBaseAddr = cnBaseAddr;
+    cpsThis->nUnits = cnUnits;
+    cpsThis->nInFlight = cnUnits;
+
+    for ( nIdx = 0; cnUnits > nIdx; ++nIdx )
+    {
+        _pushDirty(cpsThis, nIdx);
+    }
+
+    return cpsThis;
+
+__error:
+    mt25qxPoolFree(cpsThis);
+    return NULL;
+}
+
+void
+mt25qxPoolFree(
+    void * pvThis
+) {
+    mt25qxPool_s * const cpsThis = (mt25qxPool_s *)pvThis;
+
+    if ( NULL == cpsThis )
+    {
+        return;
+    }
+
+    free(cpsThis->pnErased);
+    free(cpsThis->pnDirty);
+    free(cpsThis->pnQueue);
+    free(cpsThis);
+}
+
+mt25qxRet_e
+mt25qxPoolIdle(
+    mt25qxPool_s * const cpsThis
+) {
+    mt25qxRet_e eRet = MROkay;
+    unsigned int nIdx = 0;
+
+    if ( NULL == cpsThis )
+    {
+        return MRFail;
+    }
+
+    /* the writer owns the flash until mt25qxPoolResume(), even between two of its page programs */
+    if ( true == cpsThis->bWriterOwned )
+    {
+        return MRBusy;
+    }
+
+    /* never block: whoever is using the flash (us or a writer) keeps it until it is idle */
+    eRet = mt25qxChkBusy(cpsThis->psFlash);
+    if ( MRIdle != eRet )
+    {
+        return eRet;
+    }
+
+    if ( cpsThis->nUnits != cpsThis->nInFlight )
+    {
+        /* suspended but the suspend timed out: still only mt25qxPoolResume() may go on with it */
+        if ( true == cpsThis->bSuspended )
+        {
+            return MRBusy;
+        }
+
+        if ( MROkay != _finishErase(cpsThis) )
+        {
+            return MRFail;
+        }
+    }
+
+    if ( 0 == cpsThis->nQueueLen )
+    {
+        return MRIdle;
+    }
+
+    nIdx = cpsThis->pnQueue[cpsThis->nQueueHead];
+    if (
+        MROkay != mt25qxTxPureCfgCmd(cpsThis->psFlash, MPCCCWriteEnable) ||
+        MROkay != mt25qxEraseStart(cpsThis->psFlash, cpsThis->nBaseAddr + nIdx * __EBI_MT25Qx_POOL_UNIT_SIZE, MES4KB)
+    ) {
+        return MRFail;
+    }
+
+    cpsThis->nQueueHead = ( cpsThis->nQueueHead + 1 ) % cpsThis->nUnits;
+    --cpsThis->nQueueLen;
+    _BIT_CLR(cpsThis->pnDirty, nIdx);
+    cpsThis->nInFlight = nIdx;
+    return MRBusy;
+}
+
+mt25qxRet_e
+mt25qxPoolAcquire(
+    mt25qxPool_s * const cpsThis,
+    unsigned int * const cpnAddr
+) {
+    const unsigned int cnWords = ( NULL == cpsThis ) ? ( 0 ) : ( _WORDS(cpsThis->nUnits) ) ;
+    unsigned int nWord = 0;
+    unsigned int nBit = 0;
+    unsigned int nCnt = 0;
+
+    if ( NULL == cpsThis || NULL == cpnAddr )
+    {
+        return MRFail;
+    }
+
+    if ( 0 == cpsThis->nErasedCount )
+    {
+        return MRBusy;
+    }
+
+    for ( nCnt = 0, nWord = cpsThis->nCursor; cnWords > nCnt; ++nCnt, nWord = ( nWord + 1 ) % cnWords )
+    {
+        if ( 0 == cpsThis->pnErased[nWord] )
+        {
+            continue;
+        }
+
+        for ( nBit = 0; 0 == ( cpsThis->pnErased[nWord] & ( 1U << nBit ) ); ++nBit ) {}
+
+        cpsThis->pnErased[nWord] &= ~( 1U << nBit );
+        --cpsThis->nErasedCount;
+        cpsThis->nCursor = nWord;
+        *cpnAddr = cpsThis->nBaseAddr + ( nWord * _BITS_PER_WORD + nBit ) * __EBI_MT25Qx_POOL_UNIT_SIZE;
+        return MROkay;
+    }
+
+    return MRFail;
+}
+
+mt25qxRet_e
+mt25qxPoolRelease(
+    mt25qxPool_s * const cpsThis,
+    const unsigned int cnAddr
+) {
+    unsigned int nIdx = 0;
+
+    if ( NULL == cpsThis || cpsThis->nBaseAddr > cnAddr )
+    {
+        return MRFail;
+    }
+
+    nIdx = ( cnAddr - cpsThis->nBaseAddr ) / __EBI_MT25Qx_POOL_UNIT_SIZE;
+    if ( cpsThis->nUnits <= nIdx )
+    {
+        return MRFail;
+    }
+
+    if ( _BIT_GET(cpsThis->pnDirty, nIdx) || cpsThis->nInFlight == nIdx )
+    {
+        return MROkay;
+    }
+
+    if ( _BIT_GET(cpsThis->pnErased, nIdx) )
+    {
+        _BIT_CLR(cpsThis->pnErased, nIdx);
+        --cpsThis->nErasedCount;
+    }
+
+    _pushDirty(cpsThis, nIdx);
+    return MROkay;
+}
+
+mt25qxRet_e
+mt25qxPoolSuspend(
+    mt25qxPool_s * const cpsThis,
+    const unsigned int nTimeoutMs
+) {
+    mt25qxRet_e eRet = MROkay;
+
+    if ( NULL == cpsThis )
+    {
+        return MRFail;
+    }
+
+    /* an erase already done is accounted for by mt25qxPoolIdle() after mt25qxPoolResume() */
+    if ( cpsThis->nUnits != cpsThis->nInFlight && false == cpsThis->bSuspended )
+    {
+        eRet = mt25qxChkBusy(cpsThis->psFlash);
+        if ( MRBusy == eRet )
+        {
+            if ( MROkay != mt25qxTxPureCfgCmd(cpsThis->psFlash, MPCCCSuspend) )
+            {
+                return MRFail;
+            }
+
+            cpsThis->bSuspended = true;
+        }
+        else if ( MRIdle != eRet )
+        {
+            return eRet;
+        }
+    }
+
+    /* suspend latency is tens of microseconds, try once before sleeping */
+    eRet = mt25qxChkBusy(cpsThis->psFlash);
+    if ( MRBusy == eRet )
+    {
+        eRet = mt25qxWaitIdle(cpsThis->psFlash, nTimeoutMs);
+    }
+
+    /* from now on mt25qxPoolIdle() starts no erase, whether one was suspended or not */
+    if ( MRIdle == eRet )
+    {
+        cpsThis->bWriterOwned = true;
+    }
+
+    return eRet;
+}
+
+mt25qxRet_e
+mt25qxPoolResume(
+    mt25qxPool_s * const cpsThis
+) {
+    mt25qxRet_e eRet = MROkay;
+
+    if ( NULL == cpsThis )
+    {
+        return MRFail;
+    }
+
+    if ( false == cpsThis->bWriterOwned && false == cpsThis->bSuspended )
+    {
+        return MROkay;
+    }
+
+    /* the last page program of the writer has to be done first */
+    eRet = mt25qxChkBusy(cpsThis->psFlash);
+    if ( MRIdle != eRet )
+    {
+        return eRet;
+    }
+
+    /* only an erase that was actually suspended is resumed */
+    if ( true == cpsThis->bSuspended && MROkay != mt25qxTxPureCfgCmd(cpsThis->psFlash, MPCCCResume) )
+    {
+        return MRFail;
+    }
+
+    cpsThis->bSuspended = false;
+    cpsThis->bWriterOwned = false;
+    return MROkay;
+}
+
+unsigned int
+mt25qxPoolErasedCount(
+    const mt25qxPool_s * const cpsThis
+) {
+    return ( NULL == cpsThis ) ? ( 0 ) : ( cpsThis->nErasedCount ) ;
+}
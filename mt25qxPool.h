@@ -0,0 +1,133 @@
+#ifndef __EBI_MT25Qx_POOL_H
+#define __EBI_MT25Qx_POOL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include "mt25qx.h"
+
+#define __EBI_MT25Qx_POOL_UNIT_SIZE 4096U
+
+typedef struct mt25qxPool_s mt25qxPool_s;
+
+/**
+ * @brief make a pre-erase pool over a range of 4KB subsectors via dynamic memory
+ * @param cpsFlash pointer to the mt25qx_s instance the pool erases on
+ * @param cnBaseAddr 0x00000000 + ( N * __EBI_MT25Qx_POOL_UNIT_SIZE )
+ * @param cnUnits amount of 4KB subsectors managed by this pool
+ * @return pointer to this pool
+ * @details
+ * - the content of every subsector is unknown at first, so all of them start as dirty
+ */
+mt25qxPool_s *
+mt25qxPoolMake(
+    mt25qx_s * const cpsFlash,
+    const unsigned int cnBaseAddr,
+    const unsigned int cnUnits
+);
+
+/**
+ * @brief free dynamic memory
+ * @param pvThis pointer to this pool
+ */
+void
+mt25qxPoolFree(
+    void * pvThis
+);
+
+/**
+ * @brief background step: finish the erase in flight and start the next one
+ * @param cpsThis pointer to this pool
+ * @return MRBusy, MRIdle, MRFail
+ * @details
+ * - MRBusy: an erase is in flight or suspended, or the flash belongs to a writer between
+ *   mt25qxPoolSuspend() and mt25qxPoolResume(), call again later
+ * - MRIdle: every released subsector has been erased
+ * - MRFail: bus error, or a subsector failed to erase and has been dropped from the pool
+ * - this function does not put the thread to sleep, call it from the idle loop
+ * @warning
+ * - not thread safe
+ */
+mt25qxRet_e
+mt25qxPoolIdle(
+    mt25qxPool_s * const cpsThis
+);
+
+/**
+ * @brief hand out a pre-erased subsector
+ * @param cpsThis pointer to this pool
+ * @param cpnAddr pointer to store the address of the subsector
+ * @return MROkay, MRBusy, MRFail
+ * @details
+ * - MRBusy: no subsector is erased yet, keep calling mt25qxPoolIdle()
+ * - does not touch the bus
+ */
+mt25qxRet_e
+mt25qxPoolAcquire(
+    mt25qxPool_s * const cpsThis,
+    unsigned int * const cpnAddr
+);
+
+/**
+ * @brief give a subsector back to be erased in the background
+ * @param cpsThis pointer to this pool
+ * @param cnAddr any address inside the subsector
+ * @return MROkay, MRFail
+ */
+mt25qxRet_e
+mt25qxPoolRelease(
+    mt25qxPool_s * const cpsThis,
+    const unsigned int cnAddr
+);
+
+/**
+ * @brief make the flash available to a writer, suspending the erase in flight if there is one
+ * @param cpsThis pointer to this pool
+ * @param nTimeoutMs timeout in milliseconds
+ * @return MRIdle, MRBusy, MRFail
+ * @details
+ * - call it before programming a subsector got from mt25qxPoolAcquire()
+ * - MRIdle: the flash belongs to the writer, also when no erase was in flight; the erase stays
+ *   suspended, and mt25qxPoolIdle() starts nothing, until mt25qxPoolResume(): any amount of pages
+ *   can be programmed in between
+ * @warning
+ * - this function may let thread sleep while waiting for the suspend latency
+ * - the background erase is stalled until mt25qxPoolResume() is called
+ */
+mt25qxRet_e
+mt25qxPoolSuspend(
+    mt25qxPool_s * const cpsThis,
+    const unsigned int nTimeoutMs
+);
+
+/**
+ * @brief give the flash back after mt25qxPoolSuspend() and let the erase in flight go on
+ * @param cpsThis pointer to this pool
+ * @return MROkay, MRBusy, MRFail
+ * @details
+ * - MRBusy: the writer's last page program is not done yet, call again later
+ * - the erase is resumed only if mt25qxPoolSuspend() actually suspended one
+ * - MROkay also if mt25qxPoolSuspend() was not called
+ * - does not put the thread to sleep
+ */
+mt25qxRet_e
+mt25qxPoolResume(
+    mt25qxPool_s * const cpsThis
+);
+
+/**
+ * @brief amount of subsectors ready to be handed out
+ * @param cpsThis pointer to this pool
+ * @return amount of erased subsectors
+ */
+unsigned int
+mt25qxPoolErasedCount(
+    const mt25qxPool_s * const cpsThis
+);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __EBI_MT25Qx_POOL_H */
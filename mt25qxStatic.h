@@ -0,0 +1,475 @@
+/**
+ * @brief compile-time configured mt25qx: no heap, no function pointers, no runtime mode dispatch
+ * @details
+ * - define the parameters, then include this file; include it again with other parameters for
+ *   another device, the parameters are undefined at the end
+ *   - __EBI_MT25Qx_STATIC_NAME: prefix of the generated type and functions, e.g. extFlash
+ *   - __EBI_MT25Qx_STATIC_SPI_MODE: MSMQuadSpi, MSMDualSpi or MSMStandardSpi
+ *   - __EBI_MT25Qx_STATIC_4BYTES_ADDR: 1 for parts larger than 128Mb, 0 otherwise
+ *   - __EBI_MT25Qx_STATIC_READ_DUMMY: fast read dummy clock cycles, 8 if not defined
+ *   - __EBI_MT25Qx_STATIC_CFG_CMD, __EBI_MT25Qx_STATIC_RX_DATA, __EBI_MT25Qx_STATIC_TX_DATA,
+ *     __EBI_MT25Qx_STATIC_SLEEP: low layer functions with the mt25qxCfgCmd_f, mt25qxRxData_f,
+ *     mt25qxTxData_f and mt25qxSleepMs_f signatures, called directly: declare them static inline
+ *     before the include to have them inlined
+ * - generates NAME_s, to be kept in caller-provided (static) storage, and static inline
+ *   NAMEInit(), NAMEGetId(), NAMEGetReg(), NAMESetReg(), NAMEChkBusy(), NAMEWaitIdle(), NAMEFastRead(), NAMEPageProgramStart(),
+ *   NAMEPageProgram(), NAMEEraseStart(), NAMEErase(), NAMETxPureCfgCmd(), same behavior as the
+ *   mt25qx functions of the same name
+ * - every function but NAMEInit() returns MRFail until NAMEInit() succeeded, as mt25qxMake() gives
+ *   no instance for a device that fails the checks
+ * - command descriptors are constant and built at compile time, a call only fills in the address
+ *   and the data length
+ * @warning
+ * - __EBI_MT25Qx_METRICS and __EBI_MT25Qx_TRACE have no effect on this variant
+ *
+ * @code
+ * static inline mt25qxRet_e extCfgCmd(const mt25qxCfgCmd_s * const cpcsCfgCmd) { ... }
+ * ...
+ * #define __EBI_MT25Qx_STATIC_NAME extFlash
+ * #define __EBI_MT25Qx_STATIC_SPI_MODE MSMQuadSpi
+ * #define __EBI_MT25Qx_STATIC_4BYTES_ADDR 1
+ * #define __EBI_MT25Qx_STATIC_CFG_CMD extCfgCmd
+ * #define __EBI_MT25Qx_STATIC_RX_DATA extRxData
+ * #define __EBI_MT25Qx_STATIC_TX_DATA extTxData
+ * #define __EBI_MT25Qx_STATIC_SLEEP extSleepMs
+ * #include "mt25qxStatic.h"
+ *
+ * static extFlash_s sExtFlash;
+ * extFlashInit(&sExtFlash);
+ * @endcode
+ */
+
+#ifndef __EBI_MT25Qx_STATIC_H
+#define __EBI_MT25Qx_STATIC_H
+
+#include "mt25qx.h"
+
+#define _MT25Qx_STATIC_CAT2(a, b) a##b
+#define _MT25Qx_STATIC_CAT(a, b) _MT25Qx_STATIC_CAT2(a, b)
+#define _MT25Qx_STATIC_FN(suffix) _MT25Qx_STATIC_CAT(__EBI_MT25Qx_STATIC_NAME, suffix)
+
+#define _MT25Qx_STATIC_4BYTES ( ( 0 != __EBI_MT25Qx_STATIC_4BYTES_ADDR ) ? ( true ) : ( false ) )
+
+#define _MT25Qx_STATIC_READY(cpsThis) ( ( NULL != ( cpsThis ) && true == ( cpsThis )->bReady ) ? ( true ) : ( false ) )
+
+#define _MT25Qx_STATIC_DATA_WIRES ( (mt25qxWireAmount_e)( \
+    ( MSMQuadSpi == __EBI_MT25Qx_STATIC_SPI_MODE ) ? ( MWA4Wire ) : \
+    ( MSMDualSpi == __EBI_MT25Qx_STATIC_SPI_MODE ) ? ( MWA2Wire ) : ( MWA1Wire ) ) )
+
+#define _MT25Qx_STATIC_READ_CODE ( (unsigned char)( \
+    ( MSMQuadSpi == __EBI_MT25Qx_STATIC_SPI_MODE ) ? ( 0x6B ) : \
+    ( MSMDualSpi == __EBI_MT25Qx_STATIC_SPI_MODE ) ? ( 0x3B ) : ( 0x0B ) ) )
+
+#define _MT25Qx_STATIC_PROGRAM_CODE ( (unsigned char)( \
+    ( MSMQuadSpi == __EBI_MT25Qx_STATIC_SPI_MODE ) ? ( 0x32 ) : \
+    ( MSMDualSpi == __EBI_MT25Qx_STATIC_SPI_MODE ) ? ( 0xA2 ) : ( 0x02 ) ) )
+
+/* mt25qxCfgCmd_s initializer: code, address wires, data length, data wires, dummy cycles */
+#define _MT25Qx_STATIC_CMD(nCode, eAddrWires, zDataLen, eDataWires, nDummy) \
+    { { (nCode), MWA1Wire }, { 0, (eAddrWires) }, { (zDataLen), (eDataWires) }, _MT25Qx_STATIC_4BYTES, (nDummy) }
+
+#endif /* __EBI_MT25Qx_STATIC_H */
+
+#if \
+    !defined(__EBI_MT25Qx_STATIC_NAME) || !defined(__EBI_MT25Qx_STATIC_SPI_MODE) || \
+    !defined(__EBI_MT25Qx_STATIC_4BYTES_ADDR) || !defined(__EBI_MT25Qx_STATIC_CFG_CMD) || \
+    !defined(__EBI_MT25Qx_STATIC_RX_DATA) || !defined(__EBI_MT25Qx_STATIC_TX_DATA) || \
+    !defined(__EBI_MT25Qx_STATIC_SLEEP)
+#error "mt25qxStatic.h: define __EBI_MT25Qx_STATIC_NAME, _SPI_MODE, _4BYTES_ADDR, _CFG_CMD, _RX_DATA, _TX_DATA and _SLEEP first"
+#endif
+
+#ifndef __EBI_MT25Qx_STATIC_READ_DUMMY
+#define __EBI_MT25Qx_STATIC_READ_DUMMY 8
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+typedef struct {
+    bool bReady; // ? set by NAMEInit()
+} _MT25Qx_STATIC_FN(_s);
+
+/* NAME_getId(), NAME_getReg(), NAME_chkBusy() and NAME_waitIdle() are not gated: NAMEInit() needs them */
+static inline
+mt25qxRet_e
+_MT25Qx_STATIC_FN(_getId)(
+    mt25qxId_s * const cpsId
+) {
+    static const mt25qxCfgCmd_s s_csReadId = _MT25Qx_STATIC_CMD(0x9E, MWA0Wire, sizeof(mt25qxId_s), MWA1Wire, 0);
+    mt25qxRet_e eRet = MROkay;
+
+    if ( NULL == cpsId )
+    {
+        return MRFail;
+    }
+
+    eRet = __EBI_MT25Qx_STATIC_CFG_CMD(&s_csReadId);
+    if ( MROkay != eRet )
+    {
+        return eRet;
+    }
+
+    return __EBI_MT25Qx_STATIC_RX_DATA((unsigned char *)cpsId, sizeof(mt25qxId_s));
+}
+
+static inline
+mt25qxRet_e
+_MT25Qx_STATIC_FN(_getReg)(
+    mt25qxReg_s * const cpsReg
+) {
+    static const mt25qxCfgCmd_s s_csStatusReg = _MT25Qx_STATIC_CMD(0x05, MWA0Wire, 1, MWA1Wire, 0);
+    static const mt25qxCfgCmd_s s_csFlagStatusReg = _MT25Qx_STATIC_CMD(0x70, MWA0Wire, 1, MWA1Wire, 0);
+    mt25qxRet_e eRet = MROkay;
+
+    if ( NULL == cpsReg )
+    {
+        return MRFail;
+    }
+
+    switch ( cpsReg->eReg )
+    {
+    case MRStatusReg:
+        eRet = __EBI_MT25Qx_STATIC_CFG_CMD(&s_csStatusReg);
+        break;
+
+    case MRFlagStatusReg:
+        eRet = __EBI_MT25Qx_STATIC_CFG_CMD(&s_csFlagStatusReg);
+        break;
+
+    default:
+        return MRFail;
+    }
+
+    if ( MROkay != eRet )
+    {
+        return eRet;
+    }
+
+    return __EBI_MT25Qx_STATIC_RX_DATA((unsigned char *)&cpsReg->uReg, sizeof(cpsReg->uReg));
+}
+
+static inline
+mt25qxRet_e
+_MT25Qx_STATIC_FN(_chkBusy)(void)
+{
+    mt25qxReg_s sReg;
+    mt25qxRet_e eRet = MROkay;
+
+    sReg.eReg = MRStatusReg;
+    eRet = _MT25Qx_STATIC_FN(_getReg)(&sReg);
+    if ( MROkay != eRet )
+    {
+        return eRet;
+    }
+
+    return ( 1 == sReg.uReg.sStatusReg.nWriteInProgress ) ? ( MRBusy ) : ( MRIdle ) ;
+}
+
+static inline
+mt25qxRet_e
+_MT25Qx_STATIC_FN(_waitIdle)(
+    const unsigned int nTimeoutMs
+) {
+    unsigned int nTryTimes = ( 0 == nTimeoutMs ) ? ( 1 ) : ( nTimeoutMs ) ;
+    mt25qxRet_e eRet = MRBusy;
+
+    do {
+        __EBI_MT25Qx_STATIC_SLEEP(1);
+
+        eRet = _MT25Qx_STATIC_FN(_chkBusy)();
+        --nTryTimes;
+    } while ( MRBusy == eRet && nTryTimes > 0 );
+
+    return eRet;
+}
+
+static inline
+mt25qxRet_e
+_MT25Qx_STATIC_FN(TxPureCfgCmd)(
+    _MT25Qx_STATIC_FN(_s) * const cpsThis,
+    const mt25qxPureCfgCmdCode_e ceCode
+) {
+    mt25qxCfgCmd_s sCfgCmd = _MT25Qx_STATIC_CMD(0, MWA0Wire, 0, MWA0Wire, 0);
+
+    if ( false == _MT25Qx_STATIC_READY(cpsThis) )
+    {
+        return MRFail;
+    }
+
+    sCfgCmd.sCode.nVal = (unsigned char)ceCode;
+    return __EBI_MT25Qx_STATIC_CFG_CMD(&sCfgCmd);
+}
+
+static inline
+mt25qxRet_e
+_MT25Qx_STATIC_FN(GetReg)(
+    _MT25Qx_STATIC_FN(_s) * const cpsThis,
+    mt25qxReg_s * const cpsReg
+) {
+    return ( true == _MT25Qx_STATIC_READY(cpsThis) ) ? ( _MT25Qx_STATIC_FN(_getReg)(cpsReg) ) : ( MRFail ) ;
+}
+
+static inline
+mt25qxRet_e
+_MT25Qx_STATIC_FN(GetId)(
+    _MT25Qx_STATIC_FN(_s) * const cpsThis,
+    mt25qxId_s * const cpsId
+) {
+    return ( true == _MT25Qx_STATIC_READY(cpsThis) ) ? ( _MT25Qx_STATIC_FN(_getId)(cpsId) ) : ( MRFail ) ;
+}
+
+/**
+ * @brief same as mt25qxSetReg(): only the status register can be written
+ */
+static inline
+mt25qxRet_e
+_MT25Qx_STATIC_FN(SetReg)(
+    _MT25Qx_STATIC_FN(_s) * const cpsThis,
+    const mt25qxReg_s * const cpcsReg
+) {
+    static const mt25qxCfgCmd_s s_csStatusReg = _MT25Qx_STATIC_CMD(0x01, MWA0Wire, 1, MWA1Wire, 0);
+    mt25qxRet_e eRet = MROkay;
+
+    if ( false == _MT25Qx_STATIC_READY(cpsThis) || NULL == cpcsReg || MRStatusReg != cpcsReg->eReg )
+    {
+        return MRFail;
+    }
+
+    eRet = __EBI_MT25Qx_STATIC_CFG_CMD(&s_csStatusReg);
+    if ( MROkay != eRet )
+    {
+        return eRet;
+    }
+
+    return __EBI_MT25Qx_STATIC_TX_DATA((const unsigned char *)&cpcsReg->uReg, sizeof(cpcsReg->uReg));
+}
+
+static inline
+mt25qxRet_e
+_MT25Qx_STATIC_FN(ChkBusy)(
+    _MT25Qx_STATIC_FN(_s) * const cpsThis
+) {
+    return ( true == _MT25Qx_STATIC_READY(cpsThis) ) ? ( _MT25Qx_STATIC_FN(_chkBusy)() ) : ( MRFail ) ;
+}
+
+static inline
+mt25qxRet_e
+_MT25Qx_STATIC_FN(WaitIdle)(
+    _MT25Qx_STATIC_FN(_s) * const cpsThis,
+    const unsigned int nTimeoutMs
+) {
+    return ( true == _MT25Qx_STATIC_READY(cpsThis) ) ? ( _MT25Qx_STATIC_FN(_waitIdle)(nTimeoutMs) ) : ( MRFail ) ;
+}
+
+/**
+ * @brief same as mt25qxFastRead(): cnAddr has to be page aligned
+ */
+static inline
+mt25qxRet_e
+_MT25Qx_STATIC_FN(FastRead)(
+    _MT25Qx_STATIC_FN(_s) * const cpsThis,
+    const unsigned int cnAddr,
+    unsigned char * const cpnDataBuf,
+    const size_t czDataLen
+) {
+    mt25qxCfgCmd_s sCfgCmd = _MT25Qx_STATIC_CMD(
+        _MT25Qx_STATIC_READ_CODE, MWA1Wire, 0, _MT25Qx_STATIC_DATA_WIRES, __EBI_MT25Qx_STATIC_READ_DUMMY
+    );
+    mt25qxRet_e eRet = MROkay;
+
+    if ( false == _MT25Qx_STATIC_READY(cpsThis) || NULL == cpnDataBuf || 0 != ( cnAddr & 0x000000FF ) )
+    {
+        return MRFail;
+    }
+
+    if ( 0 == czDataLen )
+    {
+        return MROkay;
+    }
+
+    sCfgCmd.sAddr.nVal = cnAddr;
+    sCfgCmd.sData.zDataLen = czDataLen;
+
+    eRet = __EBI_MT25Qx_STATIC_CFG_CMD(&sCfgCmd);
+    if ( MROkay != eRet )
+    {
+        return eRet;
+    }
+
+    return __EBI_MT25Qx_STATIC_RX_DATA(cpnDataBuf, czDataLen);
+}
+
+static inline
+mt25qxRet_e
+_MT25Qx_STATIC_FN(PageProgramStart)(
+    _MT25Qx_STATIC_FN(_s) * const cpsThis,
+    const unsigned int cnAddr,
+    const unsigned char * const cpcnDataBuf,
+    const size_t czDataLen
+) {
+    mt25qxCfgCmd_s sCfgCmd = _MT25Qx_STATIC_CMD(
+        _MT25Qx_STATIC_PROGRAM_CODE, MWA1Wire, 0, _MT25Qx_STATIC_DATA_WIRES, 0
+    );
+    mt25qxRet_e eRet = MROkay;
+
+    if ( false == _MT25Qx_STATIC_READY(cpsThis) || NULL == cpcnDataBuf )
+    {
+        return MRFail;
+    }
+
+    if ( 0 == czDataLen )
+    {
+        return MROkay;
+    }
+
+    sCfgCmd.sAddr.nVal = cnAddr;
+    sCfgCmd.sData.zDataLen = ( czDataLen > __EBI_MT25Qx_PAGE_SIZE ) ? ( __EBI_MT25Qx_PAGE_SIZE ) : ( czDataLen );
+
+    eRet = __EBI_MT25Qx_STATIC_CFG_CMD(&sCfgCmd);
+    if ( MROkay != eRet )
+    {
+        return eRet;
+    }
+
+    return __EBI_MT25Qx_STATIC_TX_DATA(cpcnDataBuf, sCfgCmd.sData.zDataLen);
+}
+
+static inline
+mt25qxRet_e
+_MT25Qx_STATIC_FN(PageProgram)(
+    _MT25Qx_STATIC_FN(_s) * const cpsThis,
+    const unsigned int cnAddr,
+    const unsigned char * const cpcnDataBuf,
+    const size_t czDataLen
+) {
+    const mt25qxRet_e ceRet = _MT25Qx_STATIC_FN(PageProgramStart)(cpsThis, cnAddr, cpcnDataBuf, czDataLen);
+
+    // ! needs to sleep for 1ms after page programming (to solve the timing problem)
+    if ( MROkay == ceRet && 0 != czDataLen )
+    {
+        __EBI_MT25Qx_STATIC_SLEEP(1);
+    }
+
+    return ceRet;
+}
+
+static inline
+mt25qxRet_e
+_MT25Qx_STATIC_FN(EraseStart)(
+    _MT25Qx_STATIC_FN(_s) * const cpsThis,
+    const unsigned int cnAddr,
+    const mt25qxEraseSize_e ceSize
+) {
+    mt25qxCfgCmd_s sCfgCmd = _MT25Qx_STATIC_CMD(0x20, MWA1Wire, 0, MWA0Wire, 0);
+
+    if ( false == _MT25Qx_STATIC_READY(cpsThis) )
+    {
+        return MRFail;
+    }
+
+    switch ( ceSize )
+    {
+    case MES4KB:
+        sCfgCmd.sAddr.nVal = cnAddr;
+        break;
+
+    case MES32KB:
+        sCfgCmd.sCode.nVal = 0x52;
+        sCfgCmd.sAddr.nVal = cnAddr;
+        break;
+
+    default: /* MESBulk */
+        sCfgCmd.sCode.nVal = 0x60;
+        sCfgCmd.sAddr.eWireAmount = MWA0Wire;
+        break;
+    }
+
+    return __EBI_MT25Qx_STATIC_CFG_CMD(&sCfgCmd);
+}
+
+static inline
+mt25qxRet_e
+_MT25Qx_STATIC_FN(Erase)(
+    _MT25Qx_STATIC_FN(_s) * const cpsThis,
+    const unsigned int cnAddr,
+    const mt25qxEraseSize_e ceSize
+) {
+    const mt25qxRet_e ceRet = _MT25Qx_STATIC_FN(EraseStart)(cpsThis, cnAddr, ceSize);
+
+    if ( MROkay == ceRet )
+    {
+        __EBI_MT25Qx_STATIC_SLEEP(( MES4KB == ceSize ) ? ( 50 ) : ( MES32KB == ceSize ) ? ( 100 ) : ( 153000 ));
+    }
+
+    return ceRet;
+}
+
+/**
+ * @brief reset the device, check the ID and the address mode against the build parameters
+ * @param cpsThis pointer to caller-provided storage, e.g. a static NAME_s
+ * @return MROkay, MRFail
+ */
+static inline
+mt25qxRet_e
+_MT25Qx_STATIC_FN(Init)(
+    _MT25Qx_STATIC_FN(_s) * const cpsThis
+) {
+    static const mt25qxCfgCmd_s s_csResetEnable = _MT25Qx_STATIC_CMD(0x66, MWA0Wire, 0, MWA0Wire, 0);
+    static const mt25qxCfgCmd_s s_csResetMemory = _MT25Qx_STATIC_CMD(0x99, MWA0Wire, 0, MWA0Wire, 0);
+    static const mt25qxCfgCmd_s s_csEnter4BytesAddr = _MT25Qx_STATIC_CMD(0xB7, MWA0Wire, 0, MWA0Wire, 0);
+    mt25qxId_s sId;
+    mt25qxReg_s sReg;
+
+    if ( NULL == cpsThis )
+    {
+        return MRFail;
+    }
+
+    sReg.eReg = MRFlagStatusReg;
+    cpsThis->bReady = false;
+
+    if (
+        MROkay != __EBI_MT25Qx_STATIC_CFG_CMD(&s_csResetEnable) ||
+        MROkay != __EBI_MT25Qx_STATIC_CFG_CMD(&s_csResetMemory) ||
+        MRIdle != _MT25Qx_STATIC_FN(_waitIdle)(10) ||
+        MROkay != _MT25Qx_STATIC_FN(_getId)(&sId) ||
+        0x20 != sId.nManufacturer
+    ) {
+        return MRFail;
+    }
+
+    /* the address width is fixed by the build: it has to be the one the part needs */
+    if ( ( 0x18 < sId.nDevSize ) != _MT25Qx_STATIC_4BYTES )
+    {
+        return MRFail;
+    }
+
+    if (
+        true == _MT25Qx_STATIC_4BYTES && (
+            MRIdle != _MT25Qx_STATIC_FN(_waitIdle)(10) ||
+            MROkay != __EBI_MT25Qx_STATIC_CFG_CMD(&s_csEnter4BytesAddr) ||
+            MRIdle != _MT25Qx_STATIC_FN(_waitIdle)(10) ||
+            MROkay != _MT25Qx_STATIC_FN(_getReg)(&sReg) ||
+            1 != sReg.uReg.sFlagStatusReg.nAddrMode
+        )
+    ) {
+        return MRFail;
+    }
+
+    cpsThis->bReady = true;
+    return MROkay;
+}
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#undef __EBI_MT25Qx_STATIC_NAME
+#undef __EBI_MT25Qx_STATIC_SPI_MODE
+#undef __EBI_MT25Qx_STATIC_4BYTES_ADDR
+#undef __EBI_MT25Qx_STATIC_READ_DUMMY
+#undef __EBI_MT25Qx_STATIC_CFG_CMD
+#undef __EBI_MT25Qx_STATIC_RX_DATA
+#undef __EBI_MT25Qx_STATIC_TX_DATA
+#undef __EBI_MT25Qx_STATIC_SLEEP
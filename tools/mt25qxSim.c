@@ -0,0 +1,379 @@
+#include "mt25qxSim.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const mt25qxSimCfg_s csSimDefaultCfg = {
+    50000000, // ? 50MHz
+    200,
+    120,
+    50000,
+    100000,
+    153000000,
+    0x20
+};
+
+static struct {
+    mt25qxSimCfg_s sCfg;
+    unsigned char * pnMem;
+    size_t zMemSize;
+    mt25qxSimStat_s sStat;
+    unsigned long long nNowNs;
+    unsigned long long nStatStartNs;
+    unsigned long long nBusyUntilNs;
+    unsigned long long nSuspendedLeftNs;
+    mt25qxCfgCmd_s sCmd;
+    bool bCmdPending;
+    bool bSuspended;
+    bool bWriteEnable;
+    bool bResetEnable;
+    bool bIs4BytesAddrMode;
+} sSim;
+
+static
+size_t
+_memSize(
+    const unsigned char cnDevSize
+) {
+    switch ( cnDevSize )
+    {
+    case 0x17: return (size_t)8 << 20;
+    case 0x18: return (size_t)16 << 20;
+    case 0x19: return (size_t)32 << 20;
+    case 0x20: return (size_t)64 << 20;
+    case 0x21: return (size_t)128 << 20;
+    case 0x22: return (size_t)256 << 20;
+    default: return 0;
+    }
+}
+
+static
+void
+_advance(
+    const unsigned long long cnNs,
+    const bool cbIsBus
+) {
+    sSim.nNowNs += cnNs;
+    if ( true == cbIsBus )
+    {
+        sSim.sStat.nBusNs += cnNs;
+    }
+}
+
+static
+unsigned long long
+_cyclesNs(
+    const unsigned long long cnCycles
+) {
+    return cnCycles * 1000000000ULL / sSim.sCfg.nBusHz;
+}
+
+static
+bool
+_isBusy(
+    void
+) {
+    return ( sSim.nNowNs < sSim.nBusyUntilNs ) ? ( true ) : ( false ) ;
+}
+
+static
+size_t
+_memOffset(
+    const mt25qxCfgCmd_s * const cpcsCfgCmd
+) {
+    const unsigned int cnAddr = ( true == cpcsCfgCmd->bIs4BytesAddrMode ) ? ( cpcsCfgCmd->sAddr.nVal ) : ( cpcsCfgCmd->sAddr.nVal & 0x00FFFFFF );
+    return cnAddr % sSim.zMemSize;
+}
+
+static
+void
+_erase(
+    const size_t czUnit,
+    const unsigned int cnUs
+) {
+    size_t zOffset = _memOffset(&sSim.sCmd);
+
+    if ( false == sSim.bWriteEnable )
+    {
+        return;
+    }
+
+    zOffset = ( czUnit >= sSim.zMemSize ) ? ( 0 ) : ( zOffset & ~( czUnit - 1 ) );
+    memset(&sSim.pnMem[zOffset], 0xFF, ( czUnit >= sSim.zMemSize ) ? ( sSim.zMemSize ) : ( czUnit ));
+    sSim.nBusyUntilNs = sSim.nNowNs + 1000ULL * cnUs;
+    sSim.bWriteEnable = false;
+    ++sSim.sStat.nErases;
+}
+
+mt25qxRet_e
+mt25qxSimOpen(
+    const mt25qxSimCfg_s * const cpcsCfg
+) {
+    const mt25qxSimCfg_s * const cpcsUse = ( NULL == cpcsCfg ) ? ( &csSimDefaultCfg ) : ( cpcsCfg );
+
+    if ( NULL != sSim.pnMem || 0 == cpcsUse->nBusHz || 0 == _memSize(cpcsUse->nDevSize) )
+    {
+        return MRFail;
+    }
+
+    memset(&sSim, 0, sizeof(sSim));
+    memcpy(&sSim.sCfg, cpcsUse, sizeof(mt25qxSimCfg_s));
+    sSim.zMemSize = _memSize(cpcsUse->nDevSize);
+    sSim.pnMem = (unsigned char *)malloc(sSim.zMemSize);
+    if ( NULL == sSim.pnMem )
+    {
+        return MRFail;
+    }
+
+    memset(sSim.pnMem, 0xFF, sSim.zMemSize);
+    return MROkay;
+}
+
+void
+mt25qxSimClose(
+    void
+) {
+    free(sSim.pnMem);
+    sSim.pnMem = NULL;
+}
+
+void
+mt25qxSimGetStat(
+    mt25qxSimStat_s * const cpsStat
+) {
+    if ( NULL == cpsStat )
+    {
+        return;
+    }
+
+    memcpy(cpsStat, &sSim.sStat, sizeof(mt25qxSimStat_s));
+    cpsStat->nNowNs = sSim.nNowNs - sSim.nStatStartNs;
+}
+
+void
+mt25qxSimResetStat(
+    void
+) {
+    memset(&sSim.sStat, 0, sizeof(mt25qxSimStat_s));
+    sSim.nStatStartNs = sSim.nNowNs;
+}
+
+unsigned long long
+mt25qxSimTickUs(
+    void
+) {
+    return sSim.nNowNs / 1000ULL;
+}
+
+mt25qxRet_e
+mt25qxSimCfgCmd(
+    const mt25qxCfgCmd_s * const cpcsCfgCmd
+) {
+    mt25qxCfgCmd_s sHeader;
+
+    if ( NULL == cpcsCfgCmd || NULL == sSim.pnMem )
+    {
+        return MRFail;
+    }
+
+    memcpy(&sHeader, cpcsCfgCmd, sizeof(mt25qxCfgCmd_s));
+    sHeader.sData.zDataLen = 0;
+    _advance(sSim.sCfg.nCmdGapNs + _cyclesNs(mt25qxCfgCmdClkCycles(&sHeader)), true);
+    ++sSim.sStat.nCmds;
+
+    memcpy(&sSim.sCmd, cpcsCfgCmd, sizeof(mt25qxCfgCmd_s));
+    sSim.bCmdPending = true;
+
+    /* only status reads and suspend are accepted while programming or erasing */
+    if ( 
+        true == _isBusy() && 
+        0x05 != cpcsCfgCmd->sCode.nVal && 
+        0x70 != cpcsCfgCmd->sCode.nVal && 
+        0x75 != cpcsCfgCmd->sCode.nVal
+    ) {
+        ++sSim.sStat.nIgnoredCmds;
+        sSim.bCmdPending = false;
+        return MROkay;
+    }
+
+    switch ( cpcsCfgCmd->sCode.nVal )
+    {
+    case 0x06: sSim.bWriteEnable = true; break;
+    case 0x04: sSim.bWriteEnable = false; break;
+    case 0xB7: sSim.bIs4BytesAddrMode = true; break;
+    case 0xE9: sSim.bIs4BytesAddrMode = false; break;
+    case 0x66: sSim.bResetEnable = true; break;
+
+    case 0x99:
+        if ( true == sSim.bResetEnable )
+        {
+            sSim.bWriteEnable = false;
+            sSim.bIs4BytesAddrMode = false;
+            sSim.bSuspended = false;
+            sSim.nBusyUntilNs = sSim.nNowNs;
+        }
+        break;
+
+    case 0x75:
+        if ( true == _isBusy() )
+        {
+            sSim.nSuspendedLeftNs = sSim.nBusyUntilNs - sSim.nNowNs;
+            sSim.nBusyUntilNs = sSim.nNowNs;
+            sSim.bSuspended = true;
+        }
+        break;
+
+    case 0x7A:
+        if ( true == sSim.bSuspended )
+        {
+            sSim.nBusyUntilNs = sSim.nNowNs + sSim.nSuspendedLeftNs;
+            sSim.bSuspended = false;
+        }
+        break;
+
+    case 0x20: _erase(4096, sSim.sCfg.nErase4KBUs); break;
+    case 0x52: _erase(32768, sSim.sCfg.nErase32KBUs); break;
+    case 0xD8: _erase(65536, sSim.sCfg.nErase32KBUs * 2); break;
+    case 0x60: 
+    case 0xC7: _erase(sSim.zMemSize, sSim.sCfg.nEraseBulkUs); break;
+
+    default:
+        break;
+    }
+
+    if ( 0x66 != cpcsCfgCmd->sCode.nVal )
+    {
+        sSim.bResetEnable = false;
+    }
+
+    return MROkay;
+}
+
+static
+void
+_dataPhase(
+    const size_t czDataLen
+) {
+    mt25qxCfgCmd_s sData = {0};
+
+    sData.sData.eWireAmount = sSim.sCmd.sData.eWireAmount;
+    sData.sData.zDataLen = czDataLen;
+    _advance(_cyclesNs(mt25qxCfgCmdClkCycles(&sData)), true);
+}
+
+mt25qxRet_e
+mt25qxSimRxData(
+    unsigned char * const cpnDataBuf, 
+    const size_t czDataLen
+) {
+    mt25qxReg_s sReg = {0};
+    mt25qxId_s sId = {0};
+    size_t zOffset = 0;
+    size_t zIdx = 0;
+
+    if ( NULL == cpnDataBuf || NULL == sSim.pnMem )
+    {
+        return MRFail;
+    }
+
+    _dataPhase(czDataLen);
+    memset(cpnDataBuf, 0, czDataLen);
+    if ( false == sSim.bCmdPending )
+    {
+        return MROkay;
+    }
+
+    sSim.bCmdPending = false;
+    switch ( sSim.sCmd.sCode.nVal )
+    {
+    case 0x9E:
+        sId.nManufacturer = 0x20;
+        sId.nDevType = 0xBA;
+        sId.nDevSize = sSim.sCfg.nDevSize;
+        memcpy(cpnDataBuf, &sId, ( czDataLen > sizeof(sId) ) ? ( sizeof(sId) ) : ( czDataLen ));
+        break;
+
+    case 0x05:
+        sReg.uReg.sStatusReg.nWriteInProgress = ( true == _isBusy() ) ? ( 1 ) : ( 0 ) ;
+        sReg.uReg.sStatusReg.nWriteEnableLatch = ( true == sSim.bWriteEnable ) ? ( 1 ) : ( 0 ) ;
+        sSim.sStat.nBusyPolls += sReg.uReg.sStatusReg.nWriteInProgress;
+        memcpy(cpnDataBuf, &sReg.uReg, ( czDataLen > sizeof(sReg.uReg) ) ? ( sizeof(sReg.uReg) ) : ( czDataLen ));
+        break;
+
+    case 0x70:
+        sReg.uReg.sFlagStatusReg.nProgramOrEraseStatus = ( true == _isBusy() ) ? ( 0 ) : ( 1 ) ;
+        sReg.uReg.sFlagStatusReg.nEraseSuspend = ( true == sSim.bSuspended ) ? ( 1 ) : ( 0 ) ;
+        sReg.uReg.sFlagStatusReg.nAddrMode = ( true == sSim.bIs4BytesAddrMode ) ? ( 1 ) : ( 0 ) ;
+        memcpy(cpnDataBuf, &sReg.uReg, ( czDataLen > sizeof(sReg.uReg) ) ? ( sizeof(sReg.uReg) ) : ( czDataLen ));
+        break;
+
+    case 0x03: case 0x0B: case 0x3B: case 0x6B: case 0xBB: case 0xEB:
+        zOffset = _memOffset(&sSim.sCmd);
+        for ( zIdx = 0; czDataLen > zIdx; ++zIdx )
+        {
+            cpnDataBuf[zIdx] = sSim.pnMem[( zOffset + zIdx ) % sSim.zMemSize];
+        }
+        sSim.sStat.nReadBytes += czDataLen;
+        break;
+
+    default:
+        break;
+    }
+
+    return MROkay;
+}
+
+mt25qxRet_e
+mt25qxSimTxData(
+    const unsigned char * const cpcnDataBuf, 
+    const size_t czDataLen
+) {
+    size_t zPage = 0;
+    size_t zIdx = 0;
+
+    if ( NULL == cpcnDataBuf || NULL == sSim.pnMem )
+    {
+        return MRFail;
+    }
+
+    _dataPhase(czDataLen);
+    if ( false == sSim.bCmdPending )
+    {
+        return MROkay;
+    }
+
+    sSim.bCmdPending = false;
+    switch ( sSim.sCmd.sCode.nVal )
+    {
+    case 0x02: case 0x32: case 0xA2: case 0x38: case 0xD2:
+        if ( false == sSim.bWriteEnable )
+        {
+            break;
+        }
+
+        /* the address wraps around inside the page, bits can only go 1 -> 0 */
+        zPage = _memOffset(&sSim.sCmd) & ~(size_t)( __EBI_MT25Qx_PAGE_SIZE - 1 );
+        for ( zIdx = 0; czDataLen > zIdx; ++zIdx )
+        {
+            sSim.pnMem[zPage + ( ( sSim.sCmd.sAddr.nVal + zIdx ) % __EBI_MT25Qx_PAGE_SIZE )] &= cpcnDataBuf[zIdx];
+        }
+
+        sSim.nBusyUntilNs = sSim.nNowNs + 1000ULL * sSim.sCfg.nPageProgramUs;
+        sSim.bWriteEnable = false;
+        sSim.sStat.nProgramBytes += czDataLen;
+        ++sSim.sStat.nPagePrograms;
+        break;
+
+    default:
+        break;
+    }
+
+    return MROkay;
+}
+
+void
+mt25qxSimSleepMs(
+    unsigned int nMs
+) {
+    sSim.sStat.nSleepNs += 1000000ULL * nMs;
+    _advance(1000000ULL * nMs, false);
+}
@@ -0,0 +1,108 @@
+#ifndef __EBI_MT25Qx_SIM_H
+#define __EBI_MT25Qx_SIM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include "mt25qx.h"
+
+typedef struct {
+    unsigned int nBusHz; // ? SPI clock
+    unsigned int nCmdGapNs; // ? host turnaround and CS high time added to every command
+    unsigned int nPageProgramUs; // ? typ. 120us
+    unsigned int nErase4KBUs; // ? typ. 50ms
+    unsigned int nErase32KBUs; // ? typ. 100ms
+    unsigned int nEraseBulkUs; // ? typ. 153s
+    unsigned char nDevSize; // ? same as mt25qxId_s.nDevSize, 0x20: 512Mb
+} mt25qxSimCfg_s;
+
+typedef struct {
+    unsigned long long nNowNs; // ? simulated time since mt25qxSimOpen()
+    unsigned long long nBusNs; // ? part of nNowNs spent transferring
+    unsigned long long nSleepNs; // ? part of nNowNs spent in mt25qxSimSleepMs()
+    unsigned long long nCmds;
+    unsigned long long nBusyPolls; // ? status register reads that returned busy
+    unsigned long long nIgnoredCmds; // ? commands sent while busy, dropped as the real device does
+    unsigned long long nReadBytes;
+    unsigned long long nProgramBytes;
+    unsigned long long nPagePrograms;
+    unsigned long long nErases;
+} mt25qxSimStat_s;
+
+/**
+ * @brief simulated MT25Qx used as the low layer of mt25qx on a build host
+ * @param cpcsCfg timing and size of the simulated device, NULL for the typical MT25QL512
+ * @return MROkay, MRFail
+ * @details
+ * - time only moves forward with bus transfers and mt25qxSimSleepMs(), so results are repeatable
+ * @warning
+ * - only one simulated device can be opened at a time
+ */
+mt25qxRet_e
+mt25qxSimOpen(
+    const mt25qxSimCfg_s * const cpcsCfg
+);
+
+/**
+ * @brief release the simulated device
+ */
+void
+mt25qxSimClose(
+    void
+);
+
+/**
+ * @brief statistics since mt25qxSimOpen() or mt25qxSimResetStat()
+ * @param cpsStat pointer to store the statistics
+ */
+void
+mt25qxSimGetStat(
+    mt25qxSimStat_s * const cpsStat
+);
+
+/**
+ * @brief clear the statistics, the simulated time keeps going
+ */
+void
+mt25qxSimResetStat(
+    void
+);
+
+/**
+ * @brief simulated monotonic clock, can be given to mt25qxSetClock()
+ */
+unsigned long long
+mt25qxSimTickUs(
+    void
+);
+
+/* low layer callbacks to be passed to mt25qxMake() */
+
+mt25qxRet_e
+mt25qxSimCfgCmd(
+    const mt25qxCfgCmd_s * const cpcsCfgCmd
+);
+
+mt25qxRet_e
+mt25qxSimRxData(
+    unsigned char * const cpnDataBuf, 
+    const size_t czDataLen
+);
+
+mt25qxRet_e
+mt25qxSimTxData(
+    const unsigned char * const cpcnDataBuf, 
+    const size_t czDataLen
+);
+
+void
+mt25qxSimSleepMs(
+    unsigned int nMs
+);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __EBI_MT25Qx_SIM_H */
@@ -0,0 +1,221 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "mt25qxSpidev.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/spi/spidev.h>
+
+/* opcode + 4 address bytes + up to 255 dummy cycles on a single wire */
+#define _HEADER_MAX_LEN ( 1 + 4 + 32 )
+
+static int nSpidevFd = -1;
+static unsigned int nSpidevSpeedHz = 0;
+
+static struct {
+    mt25qxCfgCmd_s sCfgCmd;
+    bool bPending;
+} sSpidevCmd;
+
+static
+unsigned char
+_nbits(
+    const mt25qxWireAmount_e ceWireAmount
+) {
+    switch ( ceWireAmount )
+    {
+    case MWA4Wire:
+        return 4;
+
+    case MWA2Wire:
+        return 2;
+
+    default:
+        return 1;
+    }
+}
+
+/**
+ * @brief put the opcode, address and dummy phases of the pending command in front of the data phase
+ */
+static
+mt25qxRet_e
+_transfer(
+    const unsigned char * const cpcnTxBuf,
+    unsigned char * const cpnRxBuf,
+    const size_t czDataLen
+) {
+    const mt25qxCfgCmd_s * const cpcsCfgCmd = &sSpidevCmd.sCfgCmd;
+    unsigned char anHeader[_HEADER_MAX_LEN] = {0};
+    struct spi_ioc_transfer asXfer[4];
+    unsigned int nXfer = 0;
+    unsigned int nAddrLen = ( true == cpcsCfgCmd->bIs4BytesAddrMode ) ? ( 4 ) : ( 3 ) ;
+    unsigned int nDummyWires = 1;
+    unsigned int nIdx = 0;
+
+    if ( 0 > nSpidevFd || false == sSpidevCmd.bPending )
+    {
+        return MRFail;
+    }
+
+    sSpidevCmd.bPending = false;
+    memset(asXfer, 0, sizeof(asXfer));
+
+    anHeader[0] = cpcsCfgCmd->sCode.nVal;
+    asXfer[nXfer].tx_buf = (unsigned long)&anHeader[0];
+    asXfer[nXfer].len = 1;
+    asXfer[nXfer].tx_nbits = _nbits(cpcsCfgCmd->sCode.eWireAmount);
+    ++nXfer;
+
+    if ( MWA0Wire != cpcsCfgCmd->sAddr.eWireAmount )
+    {
+        for ( nIdx = 0; nAddrLen > nIdx; ++nIdx )
+        {
+            anHeader[1 + nIdx] = (unsigned char)( cpcsCfgCmd->sAddr.nVal >> ( 8 * ( nAddrLen - 1 - nIdx ) ) );
+        }
+
+        asXfer[nXfer].tx_buf = (unsigned long)&anHeader[1];
+        asXfer[nXfer].len = nAddrLen;
+        asXfer[nXfer].tx_nbits = _nbits(cpcsCfgCmd->sAddr.eWireAmount);
+        nDummyWires = asXfer[nXfer].tx_nbits;
+        ++nXfer;
+    }
+
+    if ( 0 != cpcsCfgCmd->nDummyClkCycles )
+    {
+        /* the dummy phase runs on the address wires: cycles * wires / 8 bytes */
+        asXfer[nXfer].tx_buf = (unsigned long)&anHeader[5];
+        asXfer[nXfer].len = ( cpcsCfgCmd->nDummyClkCycles * nDummyWires + 7 ) / 8;
+        asXfer[nXfer].tx_nbits = nDummyWires;
+        if ( _HEADER_MAX_LEN - 5 < asXfer[nXfer].len )
+        {
+            return MRFail;
+        }
+        ++nXfer;
+    }
+
+    if ( 0 != czDataLen )
+    {
+        asXfer[nXfer].tx_buf = (unsigned long)cpcnTxBuf;
+        asXfer[nXfer].rx_buf = (unsigned long)cpnRxBuf;
+        asXfer[nXfer].len = czDataLen;
+        asXfer[nXfer].tx_nbits = ( NULL != cpcnTxBuf ) ? ( _nbits(cpcsCfgCmd->sData.eWireAmount) ) : ( 0 ) ;
+        asXfer[nXfer].rx_nbits = ( NULL != cpnRxBuf ) ? ( _nbits(cpcsCfgCmd->sData.eWireAmount) ) : ( 0 ) ;
+        ++nXfer;
+    }
+
+    for ( nIdx = 0; nXfer > nIdx; ++nIdx )
+    {
+        asXfer[nIdx].speed_hz = nSpidevSpeedHz;
+    }
+
+    return ( 0 > ioctl(nSpidevFd, SPI_IOC_MESSAGE(nXfer), asXfer) ) ? ( MRFail ) : ( MROkay ) ;
+}
+
+mt25qxRet_e
+mt25qxSpidevOpen(
+    const char * const cpcPath,
+    const unsigned int cnSpeedHz
+) {
+    unsigned int nMode = SPI_MODE_0 | SPI_TX_DUAL | SPI_TX_QUAD | SPI_RX_DUAL | SPI_RX_QUAD;
+    unsigned char nBits = 8;
+
+    if ( NULL == cpcPath || 0 <= nSpidevFd )
+    {
+        return MRFail;
+    }
+
+    nSpidevFd = open(cpcPath, O_RDWR);
+    if ( 0 > nSpidevFd )
+    {
+        return MRFail;
+    }
+
+    /* fall back to single wire if the controller refuses dual/quad */
+    if ( 0 > ioctl(nSpidevFd, SPI_IOC_WR_MODE32, &nMode) )
+    {
+        nMode = SPI_MODE_0;
+        if ( 0 > ioctl(nSpidevFd, SPI_IOC_WR_MODE32, &nMode) )
+        {
+            goto __error;
+        }
+    }
+
+    if ( 
+        0 > ioctl(nSpidevFd, SPI_IOC_WR_BITS_PER_WORD, &nBits) ||
+        0 > ioctl(nSpidevFd, SPI_IOC_WR_MAX_SPEED_HZ, &cnSpeedHz)
+    ) {
+        goto __error;
+    }
+
+    nSpidevSpeedHz = cnSpeedHz;
+    sSpidevCmd.bPending = false;
+    return MROkay;
+
+__error:
+    mt25qxSpidevClose();
+    return MRFail;
+}
+
+void
+mt25qxSpidevClose(
+    void
+) {
+    if ( 0 <= nSpidevFd )
+    {
+        close(nSpidevFd);
+    }
+
+    nSpidevFd = -1;
+}
+
+mt25qxRet_e
+mt25qxSpidevCfgCmd(
+    const mt25qxCfgCmd_s * const cpcsCfgCmd
+) {
+    if ( NULL == cpcsCfgCmd )
+    {
+        return MRFail;
+    }
+
+    memcpy(&sSpidevCmd.sCfgCmd, cpcsCfgCmd, sizeof(mt25qxCfgCmd_s));
+    sSpidevCmd.bPending = true;
+
+    /* commands without data phase go out now, the others wait for rx/tx to keep CS asserted */
+    if ( 0 == cpcsCfgCmd->sData.zDataLen || MWA0Wire == cpcsCfgCmd->sData.eWireAmount )
+    {
+        return _transfer(NULL, NULL, 0);
+    }
+
+    return MROkay;
+}
+
+mt25qxRet_e
+mt25qxSpidevRxData(
+    unsigned char * const cpnDataBuf, 
+    const size_t czDataLen
+) {
+    return _transfer(NULL, cpnDataBuf, czDataLen);
+}
+
+mt25qxRet_e
+mt25qxSpidevTxData(
+    const unsigned char * const cpcnDataBuf, 
+    const size_t czDataLen
+) {
+    return _transfer(cpcnDataBuf, NULL, czDataLen);
+}
+
+void
+mt25qxSpidevSleepMs(
+    unsigned int nMs
+) {
+    struct timespec sTs;
+
+    sTs.tv_sec = nMs / 1000;
+    sTs.tv_nsec = (long)( nMs % 1000 ) * 1000000L;
+    while ( 0 != nanosleep(&sTs, &sTs) && EINTR == errno ) {}
+}
@@ -0,0 +1,63 @@
+#ifndef __EBI_MT25Qx_SPIDEV_H
+#define __EBI_MT25Qx_SPIDEV_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include "mt25qx.h"
+
+/**
+ * @brief open a Linux spidev node as the low layer of mt25qx
+ * @param cpcPath e.g. "/dev/spidev0.0"
+ * @param cnSpeedHz SPI clock
+ * @return MROkay, MRFail
+ * @details
+ * - dual/quad transfers need the controller to support SPI_TX_QUAD/SPI_RX_QUAD,
+ *   use MSMStandardSpi otherwise
+ * @warning
+ * - only one spidev node can be opened at a time
+ */
+mt25qxRet_e
+mt25qxSpidevOpen(
+    const char * const cpcPath,
+    const unsigned int cnSpeedHz
+);
+
+/**
+ * @brief close the spidev node opened by mt25qxSpidevOpen()
+ */
+void
+mt25qxSpidevClose(
+    void
+);
+
+/* low layer callbacks to be passed to mt25qxMake() */
+
+mt25qxRet_e
+mt25qxSpidevCfgCmd(
+    const mt25qxCfgCmd_s * const cpcsCfgCmd
+);
+
+mt25qxRet_e
+mt25qxSpidevRxData(
+    unsigned char * const cpnDataBuf, 
+    const size_t czDataLen
+);
+
+mt25qxRet_e
+mt25qxSpidevTxData(
+    const unsigned char * const cpcnDataBuf, 
+    const size_t czDataLen
+);
+
+void
+mt25qxSpidevSleepMs(
+    unsigned int nMs
+);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __EBI_MT25Qx_SPIDEV_H */
@@ -0,0 +1,148 @@
+/**
+ * mt25qxflash: stream an image file into a MT25Qx attached to a Linux spidev node
+ *
+ * usage: mt25qxflash [-d /dev/spidevB.C] [-s hz] [-m quad|dual|std] [-a addr] image.bin
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "mt25qx.h"
+#include "mt25qxFlasher.h"
+#include "mt25qxSpidev.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+static FILE * psImageFile = NULL;
+
+static
+mt25qxRet_e
+_srcRead(
+    unsigned char * const cpnDataBuf, 
+    const size_t czDataLen, 
+    size_t * const cpzReadLen
+) {
+    *cpzReadLen = fread(cpnDataBuf, 1, czDataLen, psImageFile);
+    return ( 0 != ferror(psImageFile) ) ? ( MRFail ) : ( MROkay ) ;
+}
+
+static
+double
+_nowSec(
+    void
+) {
+    struct timespec sTs;
+    clock_gettime(CLOCK_MONOTONIC, &sTs);
+    return (double)sTs.tv_sec + (double)sTs.tv_nsec / 1e9;
+}
+
+static
+void
+_usage(
+    const char * const cpcName
+) {
+    fprintf(stderr, "usage: %s [-d /dev/spidevB.C] [-s hz] [-m quad|dual|std] [-a addr] image.bin\r\n", cpcName);
+}
+
+int main(int argc, char * argv[])
+{
+    const char * pcDev = "/dev/spidev0.0";
+    unsigned int nSpeedHz = 10000000;
+    unsigned int nAddr = 0;
+    mt25qxSpiMode_e eSpiMode = MSMQuadSpi;
+    mt25qx_s * psFlash = NULL;
+    mt25qxFlashStat_s sStat = {0};
+    mt25qxRet_e eRet = MRFail;
+    double dStart = 0.0;
+    double dElapsed = 0.0;
+    int nOpt = 0;
+
+    while ( -1 != ( nOpt = getopt(argc, argv, "d:s:m:a:h") ) )
+    {
+        switch ( nOpt )
+        {
+        case 'd':
+            pcDev = optarg;
+            break;
+
+        case 's':
+            nSpeedHz = (unsigned int)strtoul(optarg, NULL, 0);
+            break;
+
+        case 'a':
+            nAddr = (unsigned int)strtoul(optarg, NULL, 0);
+            break;
+
+        case 'm':
+            if ( 0 == strcmp(optarg, "quad") ) { eSpiMode = MSMQuadSpi; break; }
+            if ( 0 == strcmp(optarg, "dual") ) { eSpiMode = MSMDualSpi; break; }
+            if ( 0 == strcmp(optarg, "std") ) { eSpiMode = MSMStandardSpi; break; }
+            _usage(argv[0]);
+            return -1;
+
+        default:
+            _usage(argv[0]);
+            return -1;
+        }
+    }
+
+    if ( optind + 1 != argc )
+    {
+        _usage(argv[0]);
+        return -1;
+    }
+
+    psImageFile = fopen(argv[optind], "rb");
+    if ( NULL == psImageFile )
+    {
+        printf("> Cannot open %s\r\n", argv[optind]);
+        return -2;
+    }
+
+    if ( MROkay != mt25qxSpidevOpen(pcDev, nSpeedHz) )
+    {
+        printf("> Cannot open %s\r\n", pcDev);
+        fclose(psImageFile);
+        return -3;
+    }
+
+    psFlash = mt25qxMake(
+        eSpiMode, 
+        mt25qxSpidevCfgCmd, 
+        mt25qxSpidevRxData, 
+        mt25qxSpidevTxData, 
+        mt25qxSpidevSleepMs
+    );
+
+    if ( NULL == psFlash )
+    {
+        printf("> No MT25Qx found on %s\r\n", pcDev);
+        goto __exit;
+    }
+
+    dStart = _nowSec();
+    eRet = mt25qxFlashImage(psFlash, nAddr, _srcRead, &sStat);
+    dElapsed = _nowSec() - dStart;
+
+    printf("> %zu bytes at 0x%08X, CRC32C 0x%08X\r\n", sStat.zImageLen, nAddr, sStat.nImageCrc);
+    printf("> %u subsectors erased, %u pages programmed\r\n", sStat.nSectors, sStat.nPages);
+    printf("> %u jobs hidden behind busy time, %u idle waits\r\n", sStat.nHiddenJobs, sStat.nIdlePolls);
+    printf("> %.3f s, %.1f KiB/s\r\n", dElapsed, ( 0.0 < dElapsed ) ? ( sStat.zImageLen / 1024.0 / dElapsed ) : ( 0.0 ));
+
+    if ( 0 != sStat.nVerifyErrs )
+    {
+        printf("> Verify Error: %u pages, first at 0x%08X\r\n", sStat.nVerifyErrs, sStat.nFirstErrAddr);
+    }
+    else if ( MROkay != eRet )
+    {
+        printf("> Flash Error\r\n");
+    }
+
+__exit:
+    mt25qxFree(psFlash);
+    mt25qxSpidevClose();
+    fclose(psImageFile);
+
+    return ( MROkay == eRet ) ? ( 0 ) : ( -4 );
+}
@@ -0,0 +1,295 @@
+/**
+ * mt25qxpatchcheck: apply hand-made patches with mt25qxPatchApply() on a simulated MT25Qx
+ *
+ * usage: mt25qxpatchcheck
+ *
+ * every case flashes its old image, applies the patch and compares the result with the image
+ * the patch describes; the power cut cases stop the bus after N commands, let the device finish
+ * what it was busy with and apply the patch again, which has to resume from the journal;
+ * the exit status is the amount of failed cases
+ */
+#include "mt25qx.h"
+#include "mt25qxCrc.h"
+#include "mt25qxPatch.h"
+#include "mt25qxSim.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define _IMAGE_ADDR 0x00010000U
+#define _IMAGE_CAP ( 16U * __EBI_MT25Qx_PATCH_UNIT_SIZE )
+#define _SCRATCH_ADDR 0x00100000U
+#define _OLD_LEN ( 4U * __EBI_MT25Qx_PATCH_UNIT_SIZE )
+
+typedef struct {
+    unsigned char anOld[_IMAGE_CAP];
+    unsigned char anNew[_IMAGE_CAP];
+    unsigned char anPatch[64 * 1024];
+    unsigned char anRead[_IMAGE_CAP];
+    unsigned int nOldLen;
+    unsigned int nNewLen;
+    size_t zPatchLen;
+} _case_s;
+
+static _case_s sCase;
+static int nCmdsLeft = -1; // ? commands until the simulated power cut, -1: no cut
+static unsigned int nCmds = 0;
+
+/**
+ * @brief mt25qxSimCfgCmd() behind a power switch: no command reaches the device after the cut
+ */
+static
+mt25qxRet_e
+_cfgCmd(
+    const mt25qxCfgCmd_s * const cpcsCfgCmd
+) {
+    ++nCmds;
+    if ( 0 == nCmdsLeft )
+    {
+        return MRFail;
+    }
+
+    if ( 0 < nCmdsLeft )
+    {
+        --nCmdsLeft;
+    }
+
+    return mt25qxSimCfgCmd(cpcsCfgCmd);
+}
+
+static
+void
+_putLe32(
+    unsigned char * const cpnBuf,
+    const unsigned int cnVal
+) {
+    cpnBuf[0] = (unsigned char)( cnVal >> 0 );
+    cpnBuf[1] = (unsigned char)( cnVal >> 8 );
+    cpnBuf[2] = (unsigned char)( cnVal >> 16 );
+    cpnBuf[3] = (unsigned char)( cnVal >> 24 );
+}
+
+static
+void
+_begin(void)
+{
+    unsigned int nIdx = 0;
+
+    sCase.nOldLen = _OLD_LEN;
+    for ( nIdx = 0; sCase.nOldLen > nIdx; ++nIdx )
+    {
+        sCase.anOld[nIdx] = (unsigned char)( ( nIdx * 2654435761U ) >> 24 );
+    }
+
+    memcpy(sCase.anPatch, __EBI_MT25Qx_PATCH_MAGIC, 4);
+    sCase.zPatchLen = __EBI_MT25Qx_PATCH_HEADER_SIZE;
+    sCase.nNewLen = 0;
+}
+
+static
+void
+_copy(
+    const unsigned int cnSrc,
+    const unsigned int cnLen
+) {
+    sCase.anPatch[sCase.zPatchLen] = MPOCopy;
+    _putLe32(&sCase.anPatch[sCase.zPatchLen + 1], cnSrc);
+    _putLe32(&sCase.anPatch[sCase.zPatchLen + 5], cnLen);
+    sCase.zPatchLen += 9;
+
+    memcpy(&sCase.anNew[sCase.nNewLen], &sCase.anOld[cnSrc], cnLen);
+    sCase.nNewLen += cnLen;
+}
+
+static
+void
+_end(void)
+{
+    _putLe32(&sCase.anPatch[4], sCase.nOldLen);
+    _putLe32(&sCase.anPatch[8], mt25qxCrc32c(0, sCase.anOld, sCase.nOldLen));
+    _putLe32(&sCase.anPatch[12], sCase.nNewLen);
+    _putLe32(&sCase.anPatch[16], mt25qxCrc32c(0, sCase.anNew, sCase.nNewLen));
+}
+
+/**
+ * @brief flash the old image on a fresh simulated device and apply the patch
+ * @param cnCutAfter power cut after this amount of commands of the first apply, then apply again;
+ *        -1: no cut
+ * @return MROkay only if the patch is applied and the image reads back as expected
+ * @details
+ * - nCmds holds the amount of commands of the first apply
+ */
+static
+mt25qxRet_e
+_run(
+    const unsigned int cnScratchUnits,
+    const int cnCutAfter,
+    mt25qxPatchStat_s * const cpsStat
+) {
+    mt25qxPatchCfg_s sCfg = { _IMAGE_ADDR, _IMAGE_CAP, _SCRATCH_ADDR, cnScratchUnits };
+    mt25qxRet_e eRet = MRFail;
+    mt25qx_s * psFlash = NULL;
+    unsigned int nAddr = 0;
+
+    memset(cpsStat, 0, sizeof(mt25qxPatchStat_s));
+    if ( MROkay != mt25qxSimOpen(NULL) )
+    {
+        return MRFail;
+    }
+
+    nCmdsLeft = -1;
+    psFlash = mt25qxMake(MSMQuadSpi, _cfgCmd, mt25qxSimRxData, mt25qxSimTxData, mt25qxSimSleepMs);
+    if ( NULL == psFlash )
+    {
+        goto __exit;
+    }
+
+    for ( nAddr = 0; sCase.nOldLen > nAddr; nAddr += __EBI_MT25Qx_PAGE_SIZE )
+    {
+        if (
+            MROkay != mt25qxTxPureCfgCmd(psFlash, MPCCCWriteEnable) ||
+            MROkay != mt25qxPageProgram(psFlash, _IMAGE_ADDR + nAddr, &sCase.anOld[nAddr], __EBI_MT25Qx_PAGE_SIZE)
+        ) {
+            goto __exit;
+        }
+    }
+
+    nCmds = 0;
+    nCmdsLeft = cnCutAfter;
+    eRet = mt25qxPatchApply(psFlash, &sCfg, sCase.anPatch, sCase.zPatchLen, cpsStat);
+    if ( 0 <= cnCutAfter )
+    {
+        /* power back: whatever the device was busy with is done after a while */
+        nCmdsLeft = -1;
+        mt25qxSimSleepMs(200);
+        eRet = mt25qxPatchApply(psFlash, &sCfg, sCase.anPatch, sCase.zPatchLen, cpsStat);
+    }
+
+    if (
+        MROkay != eRet ||
+        MROkay != mt25qxFastRead(psFlash, _IMAGE_ADDR, sCase.anRead, _IMAGE_CAP) ||
+        0 != memcmp(sCase.anRead, sCase.anNew, sCase.nNewLen)
+    ) {
+        eRet = MRFail;
+        goto __exit;
+    }
+
+    eRet = MROkay;
+
+__exit:
+    mt25qxFree(psFlash);
+    mt25qxSimClose();
+    return eRet;
+}
+
+/**
+ * @brief cut the power at every cnStride-th command of the apply and check every resume
+ * @return 0 if every cut resumed to the new image and at least one resumed from the journal
+ */
+static
+unsigned int
+_cutEverywhere(
+    const char * const cpcName,
+    const unsigned int cnScratchUnits,
+    const unsigned int cnStride
+) {
+    mt25qxPatchStat_s sStat = {0};
+    unsigned int nTotal = 0;
+    unsigned int nCut = 0;
+    unsigned int nPoints = 0;
+    unsigned int nResumed = 0;
+    unsigned int nFailed = 0;
+
+    if ( MROkay != _run(cnScratchUnits, -1, &sStat) )
+    {
+        nFailed = 1;
+    }
+
+    nTotal = nCmds;
+    for ( nCut = 1; 0 == nFailed && nTotal > nCut; nCut += cnStride )
+    {
+        if ( MROkay != _run(cnScratchUnits, (int)nCut, &sStat) )
+        {
+            printf("%-40s cut after %u of %u commands not resumed\n", cpcName, nCut, nTotal);
+            nFailed = 1;
+        }
+
+        ++nPoints;
+        nResumed += ( true == sStat.bResumed ) ? ( 1 ) : ( 0 ) ;
+    }
+
+    printf(
+        "%-40s %s (%u cut points, %u resumed from the journal)\n",
+        cpcName, ( 0 == nFailed && 0 != nResumed ) ? ( "ok" ) : ( "FAILED" ), nPoints, nResumed
+    );
+    return ( 0 == nFailed && 0 != nResumed ) ? ( 0 ) : ( 1 );
+}
+
+static
+unsigned int
+_report(
+    const char * const cpcName,
+    const bool cbPassed,
+    const mt25qxPatchStat_s * const cpcsStat
+) {
+    printf(
+        "%-40s %s (%u steps, %u rewritten, %u stashed)\n",
+        cpcName, ( true == cbPassed ) ? ( "ok" ) : ( "FAILED" ),
+        cpcsStat->nSteps, cpcsStat->nRewritten, cpcsStat->nStashed
+    );
+    return ( true == cbPassed ) ? ( 0 ) : ( 1 );
+}
+
+int main(void)
+{
+    mt25qxPatchStat_s sSingle = {0};
+    mt25qxPatchStat_s sSplit = {0};
+    mt25qxRet_e eRet = MRFail;
+    unsigned int nFailed = 0;
+
+    /* unit 0 <- old unit 1, unit 1 <- old unit 2 as one copy */
+    _begin();
+    _copy(4096, 4096);
+    _copy(8192, 4096);
+    _copy(8192, 8192);
+    _end();
+    eRet = _run(2, -1, &sSingle);
+    nFailed += _report("single copy per subsector", MROkay == eRet && 0 == sSingle.nStashed, &sSingle);
+
+    /* the same, unit 1 built from two adjacent copies of the same old subsector: must plan the same */
+    _begin();
+    _copy(4096, 4096);
+    _copy(8192, 100);
+    _copy(8292, 3996);
+    _copy(8192, 8192);
+    _end();
+    eRet = _run(2, -1, &sSplit);
+    nFailed += _report(
+        "adjacent copies from one subsector",
+        MROkay == eRet && sSingle.nSteps == sSplit.nSteps && 0 == sSplit.nStashed,
+        &sSplit
+    );
+
+    /* units 0 and 1 swapped: a real cycle, needs one stash slot */
+    _begin();
+    _copy(4096, 4096);
+    _copy(0, 4096);
+    _copy(8192, 8192);
+    _end();
+    eRet = _run(2, -1, &sSingle);
+    nFailed += _report("swap without stash slot fails", MROkay != eRet && 0 == sSingle.nSteps, &sSingle);
+    eRet = _run(3, -1, &sSingle);
+    nFailed += _report("swap with one stash slot", MROkay == eRet && 1 == sSingle.nStashed, &sSingle);
+    nFailed += _cutEverywhere("swap, power cuts", 3, 7);
+
+    /* no stash slot at all: the journal only holds writes */
+    _begin();
+    _copy(4096, 4096);
+    _copy(8192, 100);
+    _copy(8292, 3996);
+    _copy(8192, 8192);
+    _end();
+    nFailed += _cutEverywhere("two scratch units, power cuts", 2, 7);
+
+    return (int)nFailed;
+}
@@ -0,0 +1,460 @@
+/**
+ * mt25qxreplay: replay the accesses of a captured trace on a simulated MT25Qx
+ *
+ * usage: mt25qxreplay [-m quad|dual|std] [-q] [-w fixed|wait|poll] [-c] [-f hz] trace.bin
+ *   -m  SPI mode of the driver (1-1-4, 1-1-2, 1-1-1 reads and programs)
+ *   -q  read with quad I/O fast read (1-4-4, 0xEB) instead of the driver's fast read
+ *   -w  fixed: mt25qxPageProgram/mt25qxErase typical sleeps then mt25qxWaitIdle
+ *       wait:  *Start then mt25qxWaitIdle (1ms steps)
+ *       poll:  *Start then mt25qxChkBusy without sleeping
+ *   -c  coalesce contiguous reads, and contiguous programs inside the same page
+ *   -f  simulated bus clock
+ *
+ * the trace is written by mt25qxTraceDump() of a build with __EBI_MT25Qx_TRACE,
+ * this tool is built with __EBI_MT25Qx_TRACE as well
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "mt25qx.h"
+#include "mt25qxSim.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define _READ_COALESCE_MAX ( 64U * 1024U )
+
+typedef enum {
+    _OKRead,
+    _OKProgram,
+    _OKErase
+} _opKind_e;
+
+typedef enum {
+    _WSFixed,
+    _WSWait,
+    _WSPoll
+} _waitStrategy_e;
+
+typedef struct {
+    _opKind_e eKind;
+    unsigned int nAddr;
+    unsigned int nLen; // ? _OKErase: mt25qxEraseSize_e
+} _op_s;
+
+static
+unsigned int
+_getLe(
+    const unsigned char * const cpcnBuf,
+    const unsigned int cnBytes
+) {
+    unsigned int nVal = 0;
+    unsigned int nIdx = 0;
+
+    for ( nIdx = 0; cnBytes > nIdx; ++nIdx )
+    {
+        nVal |= (unsigned int)cpcnBuf[nIdx] << ( 8 * nIdx );
+    }
+
+    return nVal;
+}
+
+/**
+ * @brief turn the bus records of a trace into flash accesses: read, program and erase
+ * @details
+ * - the file must hold the header and exactly the amount of whole records the header announces,
+ *   a truncated dump is rejected instead of being replayed in part
+ */
+static
+_op_s *
+_loadTrace(
+    const char * const cpcPath,
+    unsigned int * const cpnOps
+) {
+    unsigned char anBuf[__EBI_MT25Qx_TRACE_HEADER_SIZE] = {0};
+    FILE * psFile = fopen(cpcPath, "rb");
+    _op_s * psOps = NULL;
+    unsigned int nRecs = 0;
+    unsigned int nRecSize = 0;
+    long nFileSize = 0;
+    unsigned int nIdx = 0;
+    unsigned int nAddr = 0;
+    unsigned char nCode = 0;
+    bool bCmdPending = false;
+
+    *cpnOps = 0;
+    if ( NULL == psFile )
+    {
+        return NULL;
+    }
+
+    if ( 
+        1 != fread(anBuf, __EBI_MT25Qx_TRACE_HEADER_SIZE, 1, psFile) ||
+        0 != memcmp(anBuf, __EBI_MT25Qx_TRACE_MAGIC, 4) ||
+        __EBI_MT25Qx_TRACE_VERSION != _getLe(&anBuf[4], 2) ||
+        __EBI_MT25Qx_TRACE_RECORD_SIZE > ( nRecSize = _getLe(&anBuf[6], 2) ) ||
+        sizeof(anBuf) < nRecSize
+    ) {
+        printf("> %s is not a trace of this version\r\n", cpcPath);
+        goto __exit;
+    }
+
+    nRecs = _getLe(&anBuf[8], 4);
+    if ( 0 != fseek(psFile, 0, SEEK_END) || 0 > ( nFileSize = ftell(psFile) ) || 0 != fseek(psFile, __EBI_MT25Qx_TRACE_HEADER_SIZE, SEEK_SET) )
+    {
+        goto __exit;
+    }
+
+    nFileSize -= __EBI_MT25Qx_TRACE_HEADER_SIZE;
+    if ( 0 != nFileSize % nRecSize || (unsigned long)nRecs != (unsigned long)nFileSize / nRecSize )
+    {
+        printf("> %s holds %ld bytes of records, the header announces %u records of %u bytes\r\n", 
+            cpcPath, nFileSize, nRecs, nRecSize);
+        goto __exit;
+    }
+
+    if ( 0 != _getLe(&anBuf[12], 4) )
+    {
+        printf("> %u records were overwritten before the dump, replaying the rest\r\n", _getLe(&anBuf[12], 4));
+    }
+
+    psOps = (_op_s *)calloc(( 0 == nRecs ) ? ( 1 ) : ( nRecs ), sizeof(_op_s));
+    if ( NULL == psOps )
+    {
+        goto __exit;
+    }
+
+    for ( nIdx = 0; nRecs > nIdx; ++nIdx )
+    {
+        if ( 1 != fread(anBuf, nRecSize, 1, psFile) )
+        {
+            free(psOps);
+            psOps = NULL;
+            *cpnOps = 0;
+            goto __exit;
+        }
+
+        switch ( anBuf[12] )
+        {
+        case MTKCfgCmd:
+            nAddr = _getLe(&anBuf[4], 4);
+            nCode = anBuf[13];
+            bCmdPending = true;
+
+            if ( 0x20 == nCode || 0x52 == nCode || 0x60 == nCode || 0xC7 == nCode )
+            {
+                psOps[*cpnOps].eKind = _OKErase;
+                psOps[*cpnOps].nAddr = nAddr;
+                psOps[*cpnOps].nLen = ( 0x20 == nCode ) ? ( MES4KB ) : ( ( 0x52 == nCode ) ? ( MES32KB ) : ( MESBulk ) );
+                ++*cpnOps;
+                bCmdPending = false;
+            }
+            break;
+
+        case MTKRxData:
+            if ( true == bCmdPending && ( 0x0B == nCode || 0x3B == nCode || 0x6B == nCode || 0xEB == nCode ) )
+            {
+                psOps[*cpnOps].eKind = _OKRead;
+                psOps[*cpnOps].nAddr = nAddr;
+                psOps[*cpnOps].nLen = _getLe(&anBuf[8], 4);
+                ++*cpnOps;
+            }
+            bCmdPending = false;
+            break;
+
+        case MTKTxData:
+            if ( true == bCmdPending && ( 0x02 == nCode || 0x32 == nCode || 0xA2 == nCode ) )
+            {
+                psOps[*cpnOps].eKind = _OKProgram;
+                psOps[*cpnOps].nAddr = nAddr;
+                psOps[*cpnOps].nLen = _getLe(&anBuf[8], 4);
+                ++*cpnOps;
+            }
+            bCmdPending = false;
+            break;
+
+        default: /* MTKSleep: the strategy under test decides how to wait */
+            break;
+        }
+    }
+
+__exit:
+    fclose(psFile);
+    return psOps;
+}
+
+static
+unsigned int
+_coalesce(
+    _op_s * const cpsOps,
+    const unsigned int cnOps
+) {
+    unsigned int nOut = 0;
+    unsigned int nIdx = 0;
+    _op_s * psLast = NULL;
+    const _op_s * pcsOp = NULL;
+
+    for ( nIdx = 0; cnOps > nIdx; ++nIdx )
+    {
+        pcsOp = &cpsOps[nIdx];
+        psLast = ( 0 == nOut ) ? ( NULL ) : ( &cpsOps[nOut - 1] );
+
+        if ( 
+            NULL != psLast && psLast->eKind == pcsOp->eKind && psLast->nAddr + psLast->nLen == pcsOp->nAddr && 
+            (
+                ( _OKRead == pcsOp->eKind && _READ_COALESCE_MAX >= psLast->nLen + pcsOp->nLen ) ||
+                ( _OKProgram == pcsOp->eKind && psLast->nAddr / __EBI_MT25Qx_PAGE_SIZE == ( pcsOp->nAddr + pcsOp->nLen - 1 ) / __EBI_MT25Qx_PAGE_SIZE )
+            )
+        ) {
+            psLast->nLen += pcsOp->nLen;
+            continue;
+        }
+
+        cpsOps[nOut++] = *pcsOp;
+    }
+
+    return nOut;
+}
+
+static
+mt25qxRet_e
+_spinIdle(
+    mt25qx_s * const cpsFlash
+) {
+    mt25qxRet_e eRet = MRBusy;
+
+    while ( MRBusy == ( eRet = mt25qxChkBusy(cpsFlash) ) ) {}
+    return eRet;
+}
+
+/**
+ * @brief 1-4-4 fast read issued straight to the simulated device
+ * @param cbIs4BytesAddrMode address mode of the device, read once at start-up
+ */
+static
+mt25qxRet_e
+_quadIoRead(
+    const unsigned int cnAddr,
+    unsigned char * const cpnDataBuf,
+    const size_t czDataLen,
+    const bool cbIs4BytesAddrMode
+) {
+    mt25qxCfgCmd_s sCfgCmd = {0};
+
+    sCfgCmd.sCode.eWireAmount = MWA1Wire;
+    sCfgCmd.sCode.nVal = 0xEB;
+    sCfgCmd.sAddr.eWireAmount = MWA4Wire;
+    sCfgCmd.sAddr.nVal = cnAddr;
+    sCfgCmd.sData.eWireAmount = MWA4Wire;
+    sCfgCmd.sData.zDataLen = czDataLen;
+    sCfgCmd.nDummyClkCycles = 10;
+    sCfgCmd.bIs4BytesAddrMode = cbIs4BytesAddrMode;
+
+    if ( MROkay != mt25qxSimCfgCmd(&sCfgCmd) )
+    {
+        return MRFail;
+    }
+
+    return mt25qxSimRxData(cpnDataBuf, czDataLen);
+}
+
+static
+mt25qxRet_e
+_replay(
+    mt25qx_s * const cpsFlash,
+    const _op_s * const cpcsOp,
+    const _waitStrategy_e ceWait,
+    const bool cbQuadIo,
+    const bool cbIs4BytesAddrMode,
+    unsigned char * const cpnBuf
+) {
+    static const unsigned int cnEraseTimeoutMs[] = { 400, 1000, 460000 };
+    mt25qxRet_e eRet = MROkay;
+
+    switch ( cpcsOp->eKind )
+    {
+    case _OKRead:
+        return ( true == cbQuadIo ) ? 
+            ( _quadIoRead(cpcsOp->nAddr, cpnBuf, cpcsOp->nLen, cbIs4BytesAddrMode) ) : 
+            ( mt25qxFastRead(cpsFlash, cpcsOp->nAddr, cpnBuf, cpcsOp->nLen) ) ;
+
+    case _OKProgram:
+        eRet = mt25qxTxPureCfgCmd(cpsFlash, MPCCCWriteEnable);
+        if ( MROkay == eRet )
+        {
+            eRet = ( _WSFixed == ceWait ) ? 
+                ( mt25qxPageProgram(cpsFlash, cpcsOp->nAddr, cpnBuf, cpcsOp->nLen) ) : 
+                ( mt25qxPageProgramStart(cpsFlash, cpcsOp->nAddr, cpnBuf, cpcsOp->nLen) ) ;
+        }
+        if ( MROkay == eRet )
+        {
+            eRet = ( _WSPoll == ceWait ) ? ( _spinIdle(cpsFlash) ) : ( mt25qxWaitIdle(cpsFlash, 10) ) ;
+        }
+        return ( MRIdle == eRet ) ? ( MROkay ) : ( MRFail ) ;
+
+    default: /* _OKErase */
+        eRet = mt25qxTxPureCfgCmd(cpsFlash, MPCCCWriteEnable);
+        if ( MROkay == eRet )
+        {
+            eRet = ( _WSFixed == ceWait ) ? 
+                ( mt25qxErase(cpsFlash, cpcsOp->nAddr, (mt25qxEraseSize_e)cpcsOp->nLen) ) : 
+                ( mt25qxEraseStart(cpsFlash, cpcsOp->nAddr, (mt25qxEraseSize_e)cpcsOp->nLen) ) ;
+        }
+        if ( MROkay == eRet )
+        {
+            eRet = ( _WSPoll == ceWait ) ? ( _spinIdle(cpsFlash) ) : ( mt25qxWaitIdle(cpsFlash, cnEraseTimeoutMs[cpcsOp->nLen]) ) ;
+        }
+        return ( MRIdle == eRet ) ? ( MROkay ) : ( MRFail ) ;
+    }
+}
+
+static
+void
+_usage(
+    const char * const cpcName
+) {
+    fprintf(stderr, "usage: %s [-m quad|dual|std] [-q] [-w fixed|wait|poll] [-c] [-f hz] trace.bin\r\n", cpcName);
+}
+
+int main(int argc, char * argv[])
+{
+    static const char * const cpcWaitName[] = { "fixed", "wait", "poll" };
+    mt25qxSimCfg_s sSimCfg = { 50000000, 200, 120, 50000, 100000, 153000000, 0x20 };
+    mt25qxSimStat_s sStat = {0};
+    mt25qxReg_s sReg = {0};
+    mt25qxSpiMode_e eSpiMode = MSMQuadSpi;
+    _waitStrategy_e eWait = _WSFixed;
+    bool bQuadIo = false;
+    bool bIs4BytesAddrMode = false;
+    bool bCoalesce = false;
+    mt25qx_s * psFlash = NULL;
+    _op_s * psOps = NULL;
+    unsigned char * pnBuf = NULL;
+    unsigned int nOps = 0;
+    unsigned int nIdx = 0;
+    unsigned int nFails = 0;
+    int nOpt = 0;
+    int nRet = -1;
+
+    while ( -1 != ( nOpt = getopt(argc, argv, "m:qw:cf:h") ) )
+    {
+        switch ( nOpt )
+        {
+        case 'm':
+            if ( 0 == strcmp(optarg, "quad") ) { eSpiMode = MSMQuadSpi; break; }
+            if ( 0 == strcmp(optarg, "dual") ) { eSpiMode = MSMDualSpi; break; }
+            if ( 0 == strcmp(optarg, "std") ) { eSpiMode = MSMStandardSpi; break; }
+            _usage(argv[0]);
+            return -1;
+
+        case 'w':
+            if ( 0 == strcmp(optarg, "fixed") ) { eWait = _WSFixed; break; }
+            if ( 0 == strcmp(optarg, "wait") ) { eWait = _WSWait; break; }
+            if ( 0 == strcmp(optarg, "poll") ) { eWait = _WSPoll; break; }
+            _usage(argv[0]);
+            return -1;
+
+        case 'q':
+            bQuadIo = true;
+            break;
+
+        case 'c':
+            bCoalesce = true;
+            break;
+
+        case 'f':
+            sSimCfg.nBusHz = (unsigned int)strtoul(optarg, NULL, 0);
+            break;
+
+        default:
+            _usage(argv[0]);
+            return -1;
+        }
+    }
+
+    if ( optind + 1 != argc )
+    {
+        _usage(argv[0]);
+        return -1;
+    }
+
+    psOps = _loadTrace(argv[optind], &nOps);
+    if ( NULL == psOps )
+    {
+        printf("> Cannot load trace %s\r\n", argv[optind]);
+        return -2;
+    }
+
+    printf("> %u accesses in trace\r\n", nOps);
+    if ( true == bCoalesce )
+    {
+        nOps = _coalesce(psOps, nOps);
+        printf("> %u accesses after coalescing\r\n", nOps);
+    }
+
+    pnBuf = (unsigned char *)malloc(_READ_COALESCE_MAX);
+    if ( NULL == pnBuf || MROkay != mt25qxSimOpen(&sSimCfg) )
+    {
+        goto __exit;
+    }
+
+    memset(pnBuf, 0xA5, _READ_COALESCE_MAX);
+    psFlash = mt25qxMake(eSpiMode, mt25qxSimCfgCmd, mt25qxSimRxData, mt25qxSimTxData, mt25qxSimSleepMs);
+    if ( NULL == psFlash )
+    {
+        printf("> Cannot make mt25qx on the simulated device\r\n");
+        goto __exit;
+    }
+
+    /* the driver does not change the address mode after mt25qxMake(), the 1-4-4 reads only need it once */
+    if ( true == bQuadIo )
+    {
+        sReg.eReg = MRFlagStatusReg;
+        if ( MROkay != mt25qxGetReg(psFlash, &sReg) )
+        {
+            printf("> Cannot read the address mode of the simulated device\r\n");
+            goto __exit;
+        }
+
+        bIs4BytesAddrMode = ( 1 == sReg.uReg.sFlagStatusReg.nAddrMode ) ? ( true ) : ( false ) ;
+    }
+
+    mt25qxSimResetStat();
+    for ( nIdx = 0; nOps > nIdx; ++nIdx )
+    {
+        if ( _OKErase != psOps[nIdx].eKind && _READ_COALESCE_MAX < psOps[nIdx].nLen )
+        {
+            ++nFails;
+            continue;
+        }
+
+        nFails += ( MROkay != _replay(psFlash, &psOps[nIdx], eWait, bQuadIo, bIs4BytesAddrMode, pnBuf) ) ? ( 1 ) : ( 0 ) ;
+    }
+
+    mt25qxSimGetStat(&sStat);
+    printf("> mode %s%s, wait %s, coalesce %s, bus %u Hz\r\n", 
+        ( MSMQuadSpi == eSpiMode ) ? ( "1-1-4" ) : ( ( MSMDualSpi == eSpiMode ) ? ( "1-1-2" ) : ( "1-1-1" ) ),
+        ( true == bQuadIo ) ? ( ", reads 1-4-4" ) : ( "" ),
+        cpcWaitName[eWait], ( true == bCoalesce ) ? ( "on" ) : ( "off" ), sSimCfg.nBusHz);
+    printf("> total %.3f ms: bus %.3f ms, sleep %.3f ms\r\n", 
+        sStat.nNowNs / 1e6, sStat.nBusNs / 1e6, sStat.nSleepNs / 1e6);
+    printf("> %llu commands, %llu busy polls, %llu ignored while busy\r\n", 
+        sStat.nCmds, sStat.nBusyPolls, sStat.nIgnoredCmds);
+    printf("> %llu bytes read, %llu bytes in %llu page programs, %llu erases\r\n", 
+        sStat.nReadBytes, sStat.nProgramBytes, sStat.nPagePrograms, sStat.nErases);
+
+    if ( 0 != nFails )
+    {
+        printf("> %u accesses failed\r\n", nFails);
+    }
+
+    nRet = ( 0 == nFails ) ? ( 0 ) : ( -3 ) ;
+
+__exit:
+    mt25qxFree(psFlash);
+    mt25qxSimClose();
+    free(pnBuf);
+    free(psOps);
+
+    return nRet;
+}